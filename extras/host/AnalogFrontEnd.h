@@ -0,0 +1,242 @@
+// Host Analog Front-End Model (extras/host/AnalogFrontEnd.h)
+// Makes analogRead() behave like a mux in front of a sampling ADC instead
+// of returning the ideal value. Each channel is a source voltage behind a
+// source resistance. It reaches the mux output node through the on
+// resistance. Every switch dumps a packet of charge onto that node, and
+// each conversion shares the node with the ADC sample capacitor. Reading
+// before the node has settled therefore returns a value that still leans
+// towards the previous channel, as on the bench.
+//
+// Use with HostSim::useVirtualClock() so results do not depend on how long
+// the PC takes to sleep.
+#ifndef MUXLIB_HOST_ANALOGFRONTEND_H
+#define MUXLIB_HOST_ANALOGFRONTEND_H
+
+#include <Arduino.h>
+
+#ifndef MUXLIB_HOST_MAX_FRONT_ENDS
+    #define MUXLIB_HOST_MAX_FRONT_ENDS 4
+#endif
+
+namespace HostSim {
+    // Time-varying source, volts at a given simulated time
+    typedef double (*SourceFunction)(uint8_t channel, uint32_t micros);
+
+    // Electrical parameters, SI units. The defaults are roughly a 74HC4067
+    // in front of an AVR ADC.
+    struct FrontEndParams {
+        double onOhms;          // Mux on resistance
+        double nodeFarads;      // Mux drain, pin and trace capacitance
+        double sampleFarads;    // ADC sample-and-hold capacitor
+        double samplerOhms;     // ADC sampling switch resistance
+        double injectCoulombs;  // Charge dumped on the output by each switch
+        double vref;
+        uint8_t bits;
+        uint16_t sampleMicros;  // Acquisition window of a conversion
+        uint16_t convertMicros; // Whole conversion, clock advance per analogRead()
+    };
+
+    inline FrontEndParams defaultFrontEnd() {
+        FrontEndParams p;
+        p.onOhms = 70.0;
+        p.nodeFarads = 50e-12;
+        p.sampleFarads = 14e-12;
+        p.samplerOhms = 1e3;
+        p.injectCoulombs = 5e-12;
+        p.vref = 5.0;
+        p.bits = 10;
+        p.sampleMicros = 2;
+        p.convertMicros = 13;
+        return p;
+    }
+
+    class AnalogFrontEnd {
+    private:
+        static const uint8_t MAX_CHANNELS = 32;
+        static const uint8_t OPEN = 255;
+        
+        FrontEndParams params;
+        uint8_t signalPin;
+        uint8_t selectPins[5];
+        uint8_t numSelectPins;
+        uint8_t enablePin;
+        bool enableHigh;
+        
+        double sourceVolts[MAX_CHANNELS];
+        double sourceOhms[MAX_CHANNELS];
+        SourceFunction sourceFunction;
+        
+        uint8_t channel;        // Connected channel, OPEN when disabled
+        double nodeVolts;
+        double heldVolts;       // Left on the sample capacitor by the last conversion
+        uint32_t lastUpdate;
+        uint32_t switches;
+        
+        static AnalogFrontEnd*& slot(uint8_t index) {
+            static AnalogFrontEnd* registry[MUXLIB_HOST_MAX_FRONT_ENDS] = { nullptr };
+            return registry[index];
+        }
+        
+        static uint16_t readHook(uint8_t pin) {
+            for (uint8_t i = 0; i < MUXLIB_HOST_MAX_FRONT_ENDS; i++) {
+                if (slot(i) && slot(i)->signalPin == pin) return slot(i)->convert();
+            }
+            return pins().analog[pin];
+        }
+        
+        static void writeHook(uint8_t pin, uint8_t level) {
+            for (uint8_t i = 0; i < MUXLIB_HOST_MAX_FRONT_ENDS; i++) {
+                if (slot(i)) slot(i)->pinChanged(pin);
+            }
+        }
+        
+        double source(uint8_t ch, uint32_t now) const {
+            return sourceFunction ? sourceFunction(ch, now) : sourceVolts[ch];
+        }
+        
+        uint8_t decodeChannel() const {
+            if (enablePin != 255 && (getLevel(enablePin) == HIGH) != enableHigh) return OPEN;
+            uint8_t ch = 0;
+            for (uint8_t i = 0; i < numSelectPins; i++) {
+                ch |= getLevel(selectPins[i]) << i;
+            }
+            return ch;
+        }
+        
+        // Move the node forward to the present: an RC charge towards the
+        // connected source, or held while the switch is open
+        void evolve() {
+            uint32_t now = micros();
+            double dt = (now - lastUpdate) * 1e-6;
+            lastUpdate = now;
+            if (channel == OPEN || dt <= 0) return;
+            
+            double tau = (sourceOhms[channel] + params.onOhms) * params.nodeFarads;
+            nodeVolts += (source(channel, now) - nodeVolts) * (1.0 - exp(-dt / tau));
+        }
+        
+        void pinChanged(uint8_t pin) {
+            bool relevant = (pin == enablePin);
+            for (uint8_t i = 0; i < numSelectPins; i++) {
+                if (pin == selectPins[i]) relevant = true;
+            }
+            if (!relevant) return;
+            
+            uint8_t next = decodeChannel();
+            if (next == channel) return;
+            
+            // Break-before-make transitions inject charge too
+            evolve();
+            nodeVolts += params.injectCoulombs / params.nodeFarads;
+            channel = next;
+            switches++;
+        }
+        
+        uint16_t convert() {
+            evolve();
+            
+            // Connecting the sample capacitor shares its old charge with the node
+            double total = params.nodeFarads + params.sampleFarads;
+            double volts = (params.nodeFarads * nodeVolts + params.sampleFarads * heldVolts) / total;
+            
+            // Both then charge together through the source during acquisition
+            if (channel != OPEN) {
+                double ohms = sourceOhms[channel] + params.onOhms + params.samplerOhms;
+                double target = source(channel, micros());
+                volts += (target - volts) * (1.0 - exp(-params.sampleMicros * 1e-6 / (ohms * total)));
+            }
+            nodeVolts = volts;
+            heldVolts = volts;
+            
+            advance(params.convertMicros);
+            lastUpdate = micros();
+            return code(volts);
+        }
+        
+    public:
+        AnalogFrontEnd(uint8_t sigPin, const uint8_t* selPins, uint8_t numPins,
+                       uint8_t enPin = 255, bool enActiveHigh = false)
+            : params(defaultFrontEnd()), signalPin(sigPin), numSelectPins(numPins > 5 ? 5 : numPins),
+              enablePin(enPin), enableHigh(enActiveHigh), sourceFunction(nullptr),
+              channel(OPEN), nodeVolts(0), heldVolts(0), lastUpdate(0), switches(0) {
+            memcpy(selectPins, selPins, numSelectPins);
+            for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
+                sourceVolts[i] = 0;
+                sourceOhms[i] = 1e3;
+            }
+        }
+        
+        ~AnalogFrontEnd() {
+            detach();
+        }
+        
+        // Route analogRead() of the signal pin through this model
+        bool attach() {
+            for (uint8_t i = 0; i < MUXLIB_HOST_MAX_FRONT_ENDS; i++) {
+                if (!slot(i)) {
+                    slot(i) = this;
+                    analogModel() = readHook;
+                    pinListener() = writeHook;
+                    channel = decodeChannel();
+                    lastUpdate = micros();
+                    return true;
+                }
+            }
+            return false;
+        }
+        
+        void detach() {
+            for (uint8_t i = 0; i < MUXLIB_HOST_MAX_FRONT_ENDS; i++) {
+                if (slot(i) == this) slot(i) = nullptr;
+            }
+        }
+        
+        FrontEndParams& parameters() { return params; }
+        
+        void setSource(uint8_t ch, double volts, double ohms = 1e3) {
+            if (ch >= MAX_CHANNELS) return;
+            sourceVolts[ch] = volts;
+            sourceOhms[ch] = ohms;
+        }
+        
+        void setSourceFunction(SourceFunction function) { sourceFunction = function; }
+        
+        // Reading of a fully settled channel
+        uint16_t idealCode(uint8_t ch) const {
+            return code(source(ch, micros()));
+        }
+        
+        uint16_t code(double volts) const {
+            double full = (double)((1UL << params.bits) - 1);
+            double scaled = volts / params.vref * full + 0.5;
+            if (scaled < 0) return 0;
+            if (scaled > full) return (uint16_t)full;
+            return (uint16_t)scaled;
+        }
+        
+        // Settling wait after which a full-scale step on this channel is
+        // within half an LSB (charge injection included)
+        double requiredSettleMicros(uint8_t ch) const {
+            if (ch >= MAX_CHANNELS) return 0;
+            double tau = (sourceOhms[ch] + params.onOhms) * params.nodeFarads;
+            double step = params.vref + params.injectCoulombs / params.nodeFarads;
+            double halfLsb = params.vref / (double)(1UL << (params.bits + 1));
+            return tau * log(step / halfLsb) * 1e6;
+        }
+        
+        // Error left by the sample capacitor after a full-scale step, in
+        // LSB. Settling time cannot remove it, only a lower source
+        // impedance or a longer acquisition window can.
+        double acquisitionErrorLsb(uint8_t ch) const {
+            if (ch >= MAX_CHANNELS) return 0;
+            double total = params.nodeFarads + params.sampleFarads;
+            double tau = (sourceOhms[ch] + params.onOhms + params.samplerOhms) * total;
+            double kick = params.sampleFarads / total * exp(-params.sampleMicros * 1e-6 / tau);
+            return kick * (double)((1UL << params.bits) - 1);
+        }
+        
+        uint32_t getSwitchCount() const { return switches; }
+    };
+}
+
+#endif
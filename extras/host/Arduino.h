@@ -0,0 +1,201 @@
+// Host Arduino Shim (extras/host/Arduino.h)
+// Minimal Arduino API for building MUXLib on a PC. Pins, the ADC and the
+// clock are simulated in memory so library logic (and multi-threaded use)
+// can be exercised without hardware:
+//
+//   g++ -std=c++11 -pthread -Iextras/host -Isrc app.cpp src/MUXLib.cpp
+#ifndef MUXLIB_HOST_ARDUINO_H
+#define MUXLIB_HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <chrono>
+#include <thread>
+
+#define MUXLIB_HOST 1
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+#define DEC 10
+#define HEX 16
+
+#define digitalPinToInterrupt(p) (p)
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+typedef uint8_t byte;
+
+namespace HostSim {
+    const uint16_t PIN_COUNT = 256;
+
+    struct PinState {
+        uint8_t mode[PIN_COUNT];
+        uint8_t level[PIN_COUNT];
+        uint16_t analog[PIN_COUNT];     // analogRead() value per pin
+        uint16_t pwm[PIN_COUNT];        // Last analogWrite() value per pin
+        void (*isr[PIN_COUNT])();
+        int isrMode[PIN_COUNT];
+    };
+
+    inline PinState& pins() {
+        static PinState state;
+        return state;
+    }
+
+    // Optional analogRead() override, e.g. a front-end model
+    typedef uint16_t (*AnalogModel)(uint8_t pin);
+
+    inline AnalogModel& analogModel() {
+        static AnalogModel model = nullptr;
+        return model;
+    }
+
+    // Optional digitalWrite() observer, e.g. to see a mux switch
+    typedef void (*PinListener)(uint8_t pin, uint8_t level);
+
+    inline PinListener& pinListener() {
+        static PinListener listener = nullptr;
+        return listener;
+    }
+
+    inline std::chrono::steady_clock::time_point startTime() {
+        static std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        return start;
+    }
+
+    // Simulated time: micros() only moves when delays (or advance()) move
+    // it, so timing-dependent results are exact and repeatable. Single
+    // threaded use only.
+    struct VirtualClock {
+        bool enabled;
+        uint64_t now;
+    };
+
+    inline VirtualClock& virtualClock() {
+        static VirtualClock clock = { false, 0 };
+        return clock;
+    }
+
+    inline void useVirtualClock(bool enabled = true) { virtualClock().enabled = enabled; }
+    inline void advance(uint32_t us) { virtualClock().now += us; }
+
+    // Test inputs
+    inline void setAnalog(uint8_t pin, uint16_t value) { pins().analog[pin] = value; }
+    inline uint8_t getLevel(uint8_t pin) { return pins().level[pin]; }
+    inline uint16_t getPWM(uint8_t pin) { return pins().pwm[pin]; }
+
+    // Drive an input pin and fire its attached interrupt like the hardware would
+    inline void setLevel(uint8_t pin, uint8_t level) {
+        PinState& p = pins();
+        uint8_t previous = p.level[pin];
+        p.level[pin] = level ? HIGH : LOW;
+        
+        if (!p.isr[pin] || previous == p.level[pin]) return;
+        int mode = p.isrMode[pin];
+        if (mode == CHANGE ||
+            (mode == RISING && p.level[pin] == HIGH) ||
+            (mode == FALLING && p.level[pin] == LOW)) {
+            p.isr[pin]();
+        }
+    }
+}
+
+inline void pinMode(uint8_t pin, uint8_t mode) {
+    HostSim::pins().mode[pin] = mode;
+    if (mode == INPUT_PULLUP) HostSim::pins().level[pin] = HIGH;
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t value) {
+    HostSim::pins().level[pin] = value ? HIGH : LOW;
+    if (HostSim::pinListener()) HostSim::pinListener()(pin, value ? HIGH : LOW);
+}
+
+inline int digitalRead(uint8_t pin) {
+    return HostSim::pins().level[pin];
+}
+
+inline int analogRead(uint8_t pin) {
+    if (HostSim::analogModel()) return HostSim::analogModel()(pin);
+    return HostSim::pins().analog[pin];
+}
+
+inline void analogWrite(uint8_t pin, int value) {
+    HostSim::pins().pwm[pin] = value;
+}
+
+inline unsigned long micros() {
+    if (HostSim::virtualClock().enabled) return (unsigned long)HostSim::virtualClock().now;
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - HostSim::startTime()).count();
+}
+
+inline unsigned long millis() {
+    return micros() / 1000UL;
+}
+
+inline void delayMicroseconds(unsigned int us) {
+    if (HostSim::virtualClock().enabled) return HostSim::advance(us);
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+inline void delay(unsigned long ms) {
+    if (HostSim::virtualClock().enabled) return HostSim::advance(ms * 1000UL);
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+inline void yield() {
+    std::this_thread::yield();
+}
+
+inline void attachInterrupt(uint8_t pin, void (*isr)(), int mode) {
+    HostSim::pins().isr[pin] = isr;
+    HostSim::pins().isrMode[pin] = mode;
+}
+
+inline void detachInterrupt(uint8_t pin) {
+    HostSim::pins().isr[pin] = nullptr;
+}
+
+// Interrupts are delivered synchronously from HostSim::setLevel()
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+// Serial goes to stdout
+class HostSerial {
+public:
+    void begin(unsigned long) {}
+    size_t write(uint8_t b) { return fwrite(&b, 1, 1, stdout); }
+    size_t write(const uint8_t* data, size_t length) { return fwrite(data, 1, length, stdout); }
+    void print(const char* s) { fputs(s, stdout); }
+    void print(char c) { fputc(c, stdout); }
+    void print(long n, int base = DEC) { printf(base == HEX ? "%lX" : "%ld", n); }
+    void print(int n, int base = DEC) { print((long)n, base); }
+    void print(unsigned long n, int base = DEC) { printf(base == HEX ? "%lX" : "%lu", n); }
+    void print(unsigned int n, int base = DEC) { print((unsigned long)n, base); }
+    void print(double d, int digits = 2) { printf("%.*f", digits, d); }
+    template <typename T> void println(T value) { print(value); println(); }
+    template <typename T> void println(T value, int format) { print(value, format); println(); }
+    void println() { fputc('\n', stdout); }
+    int available() { return 0; }
+    int read() { return -1; }
+    void flush() { fflush(stdout); }
+    explicit operator bool() const { return true; }
+};
+
+inline HostSerial& hostSerial() {
+    static HostSerial serial;
+    return serial;
+}
+
+#define Serial hostSerial()
+
+#endif
@@ -0,0 +1,114 @@
+// Host Wire Shim (extras/host/Wire.h)
+// In-memory I2C bus. Every address ACKs and reads back the last byte
+// written to it, which is how the mux control registers behave; install
+// HostSim::I2CDevice hooks to model anything richer.
+#ifndef MUXLIB_HOST_WIRE_H
+#define MUXLIB_HOST_WIRE_H
+
+#include <Arduino.h>
+
+namespace HostSim {
+    // Return false from write() to NACK. read() fills up to 'length' bytes
+    // and returns how many it produced.
+    struct I2CDevice {
+        virtual ~I2CDevice() {}
+        virtual bool write(const uint8_t* data, size_t length) = 0;
+        virtual size_t read(uint8_t* buffer, size_t length) = 0;
+    };
+
+    struct I2CBus {
+        I2CDevice* devices[128];
+        uint8_t lastWrite[128];
+        bool absent[128];       // Addresses that NACK
+        uint32_t transactions;
+    };
+
+    inline I2CBus& i2c() {
+        static I2CBus bus;
+        return bus;
+    }
+
+    inline void attachI2CDevice(uint8_t address, I2CDevice* device) { i2c().devices[address & 0x7F] = device; }
+    inline void setI2CPresent(uint8_t address, bool present) { i2c().absent[address & 0x7F] = !present; }
+    inline uint8_t getI2CRegister(uint8_t address) { return i2c().lastWrite[address & 0x7F]; }
+}
+
+class TwoWire {
+private:
+    uint8_t txAddress;
+    uint8_t txBuffer[32];
+    uint8_t txLength;
+    uint8_t rxBuffer[32];
+    uint8_t rxLength;
+    uint8_t rxIndex;
+    uint32_t clock;
+
+public:
+    TwoWire() : txAddress(0), txLength(0), rxLength(0), rxIndex(0), clock(100000) {}
+
+    void begin() {}
+    void end() {}
+    void setClock(uint32_t frequency) { clock = frequency; }
+    uint32_t getClock() const { return clock; }
+
+    void beginTransmission(uint8_t address) {
+        txAddress = address & 0x7F;
+        txLength = 0;
+    }
+
+    size_t write(uint8_t value) {
+        if (txLength >= sizeof(txBuffer)) return 0;
+        txBuffer[txLength++] = value;
+        return 1;
+    }
+
+    size_t write(const uint8_t* data, size_t length) {
+        size_t written = 0;
+        while (written < length && write(data[written])) written++;
+        return written;
+    }
+
+    // 0 = ACK, 2 = address NACK (as in the Arduino core)
+    uint8_t endTransmission(bool stop = true) {
+        HostSim::I2CBus& bus = HostSim::i2c();
+        bus.transactions++;
+        if (bus.absent[txAddress]) return 2;
+        
+        if (bus.devices[txAddress]) {
+            if (!bus.devices[txAddress]->write(txBuffer, txLength)) return 2;
+        } else if (txLength) {
+            bus.lastWrite[txAddress] = txBuffer[txLength - 1];
+        }
+        return 0;
+    }
+
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t stop = 1) {
+        HostSim::I2CBus& bus = HostSim::i2c();
+        address &= 0x7F;
+        bus.transactions++;
+        rxIndex = 0;
+        rxLength = 0;
+        if (bus.absent[address]) return 0;
+        if (quantity > sizeof(rxBuffer)) quantity = sizeof(rxBuffer);
+        
+        if (bus.devices[address]) {
+            rxLength = bus.devices[address]->read(rxBuffer, quantity);
+        } else {
+            memset(rxBuffer, bus.lastWrite[address], quantity);
+            rxLength = quantity;
+        }
+        return rxLength;
+    }
+
+    int available() { return rxLength - rxIndex; }
+    int read() { return (rxIndex < rxLength) ? rxBuffer[rxIndex++] : -1; }
+};
+
+inline TwoWire& hostWire() {
+    static TwoWire wire;
+    return wire;
+}
+
+#define Wire hostWire()
+
+#endif
@@ -0,0 +1,77 @@
+// Host build of the analog front-end model: picks a settling time for an
+// HC4067 reading high-impedance sources, and shows how scan order changes
+// the error at a given settling time.
+//
+//   g++ -std=c++11 -pthread -Iextras/host -Isrc
+//       extras/host/examples/afe_settling.cpp src/MUXLib.cpp
+#include <Arduino.h>
+#include <AnalogFrontEnd.h>
+#include <MUXLib.h>
+#include <AnalogMUX.h>
+
+static uint8_t selectPins[] = {2, 3, 4, 5};
+static const uint8_t SIGNAL_PIN = 14;
+
+struct ScanError {
+    int worst;
+    double mean;
+};
+
+// Error in LSB over two passes through all channels
+static ScanError scanError(MUXLib::HC4067& mux, HostSim::AnalogFrontEnd& afe) {
+    ScanError result = { 0, 0 };
+    for (uint8_t pass = 0; pass < 2; pass++) {
+        for (uint8_t ch = 0; ch < 16; ch++) {
+            int error = (int)mux.readChannel(ch) - (int)afe.idealCode(mux.getPhysicalChannel(ch));
+            if (error < 0) error = -error;
+            if (error > result.worst) result.worst = error;
+            result.mean += error / 32.0;
+        }
+    }
+    return result;
+}
+
+int main() {
+    HostSim::useVirtualClock();
+
+    MUXLib::HC4067 mux(selectPins, SIGNAL_PIN);
+    mux.begin();
+
+    // Alternating rails behind 10k: every sequential step is full scale
+    HostSim::AnalogFrontEnd afe(SIGNAL_PIN, selectPins, 4);
+    for (uint8_t ch = 0; ch < 16; ch++) {
+        afe.setSource(ch, (ch & 0x01) ? 5.0 : 0.0, 10e3);
+    }
+    afe.attach();
+
+    double required = afe.requiredSettleMicros(0);
+    double floor = afe.acquisitionErrorLsb(0);
+    printf("settling needed: %.1f us, sample capacitor error floor: %.1f LSB\n\n", required, floor);
+    printf("settle us   sequential (worst/mean)   grouped (worst/mean)\n");
+
+    // Grouped order reads all low channels, then all high ones
+    uint8_t grouped[16];
+    for (uint8_t i = 0; i < 8; i++) {
+        grouped[i] = i * 2;
+        grouped[i + 8] = i * 2 + 1;
+    }
+
+    const uint16_t settleTimes[] = {0, 1, 2, 3, 5, 8, 10};
+    int failures = 0;
+    for (uint8_t i = 0; i < sizeof(settleTimes) / sizeof(settleTimes[0]); i++) {
+        mux.setSettlingTime(settleTimes[i]);
+        
+        mux.setChannelMap(nullptr);
+        ScanError sequential = scanError(mux, afe);
+        mux.setChannelMap(grouped);
+        ScanError groupedError = scanError(mux, afe);
+        
+        printf("%9u   %8d / %5.1f LSB       %6d / %5.1f LSB\n", settleTimes[i],
+               sequential.worst, sequential.mean, groupedError.worst, groupedError.mean);
+               
+        // Once settled, only the sample capacitor error may remain
+        if (settleTimes[i] >= required && sequential.worst > floor + 1) failures++;
+    }
+
+    return failures ? 1 : 0;
+}
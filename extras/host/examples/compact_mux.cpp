@@ -0,0 +1,76 @@
+// CompactMUX on the host: object sizes of the compact core with and
+// without features next to the MUXManager-based HC4067, then a short run
+// of every feature.
+//
+//   g++ -std=c++11 -pthread -Iextras/host -Isrc
+//       extras/host/examples/compact_mux.cpp src/MUXLib.cpp
+#include <Arduino.h>
+#include <MUXLib.h>
+#include <AnalogMUX.h>
+#include <CompactMUX.h>
+
+using namespace MUXLib;
+
+typedef CompactMUX<MUXLIB_CHIP(CHIP_HC4067)> Bare;
+typedef CompactMUX<MUXLIB_CHIP(CHIP_HC4067), WithPower> Powered;
+typedef CompactMUX<MUXLIB_CHIP(CHIP_HC4067), WithInterrupts, WithScan, WithDiagnostics, WithPower> Full;
+
+static uint8_t selectPins[] = {2, 3, 4, 5};
+static const uint8_t SIGNAL_PIN = 14;
+static const uint8_t INT_PIN = 7;
+
+static uint8_t scanned = 0;
+static uint8_t interrupted = 255;
+
+static void onScan(uint8_t channel, uint16_t value) {
+    if (value == channel * 10) scanned++;
+}
+
+static void onInterrupt(uint8_t channel) {
+    interrupted = channel;
+}
+
+int main() {
+    printf("sizeof: CompactMUX %u, + WithPower %u, + all features %u, HC4067 %u (plus heap)\n",
+           (unsigned)sizeof(Bare), (unsigned)sizeof(Powered), (unsigned)sizeof(Full), (unsigned)sizeof(HC4067));
+           
+    HostSim::useVirtualClock();
+    Full mux(selectPins, SIGNAL_PIN);
+    if (mux.begin() != MUXStatus::OK) return 1;
+    int failures = 0;
+
+    // Scan: the source on every channel reads back channel * 10
+    HostSim::analogModel() = [](uint8_t pin) -> uint16_t {
+        uint8_t ch = 0;
+        for (uint8_t i = 0; i < 4; i++) ch |= HostSim::getLevel(selectPins[i]) << i;
+        return ch * 10;
+    };
+    mux.onScan(onScan);
+    mux.setScanInterval(1);
+    mux.startScan();
+    for (uint8_t i = 0; i < 32; i++) {
+        mux.update();
+        delay(1);
+    }
+    mux.stopScan();
+    if (scanned != 32) failures++;
+
+    // Interrupt: serviced later with the channel that was selected
+    mux.attachInterrupt(onInterrupt, INT_PIN, InterruptMode::FALLING_EDGE);
+    mux.setChannel(9);
+    HostSim::setLevel(INT_PIN, LOW);
+    if (!mux.service() || interrupted != 9) failures++;
+
+    // Power: select lines parked LOW while asleep, channel restored on wake
+    mux.sleep();
+    bool parked = mux.setChannel(3) == MUXStatus::ERROR_NOT_ENABLED;
+    for (uint8_t i = 0; i < 4; i++) parked = parked && HostSim::getLevel(selectPins[i]) == LOW;
+    mux.wake();
+    if (!parked || mux.getChannel() != 9 || HostSim::getLevel(selectPins[0]) != HIGH) failures++;
+
+    MUXDiagnostics diag;
+    mux.getDiagnostics(diag);
+    printf("scanned %u, interrupt on channel %u, %u switches, %u us settling, %d failures\n",
+           scanned, interrupted, (unsigned)diag.switchCount, (unsigned)diag.settleMicros, failures);
+    return failures ? 1 : 0;
+}
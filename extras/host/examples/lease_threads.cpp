@@ -0,0 +1,58 @@
+// Host build of MUXArbiter with several threads sharing one HC4067.
+// The simulated ADC returns a value derived from the select lines, so a
+// reading taken on the wrong channel (another thread switched the mux
+// under us) shows up as a mismatch.
+//
+//   g++ -std=c++11 -pthread -Iextras/host -Isrc
+//       extras/host/examples/lease_threads.cpp src/MUXLib.cpp
+#include <Arduino.h>
+#include <MUXLib.h>
+#include <AnalogMUX.h>
+#include <MUXLease.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+static uint8_t selectPins[] = {2, 3, 4, 5};
+static const uint8_t SIGNAL_PIN = 14;
+
+static uint16_t selectedChannelValue(uint8_t pin) {
+    uint8_t channel = 0;
+    for (uint8_t i = 0; i < 4; i++) {
+        channel |= digitalRead(selectPins[i]) << i;
+    }
+    return channel * 64;
+}
+
+int main() {
+    MUXLib::HC4067 mux(selectPins, SIGNAL_PIN);
+    MUXLib::MUXArbiter arbiter(mux);
+    mux.begin();
+    mux.setSettlingTime(5);
+    HostSim::analogModel() = selectedChannelValue;
+
+    std::atomic<uint32_t> reads(0);
+    std::atomic<uint32_t> mismatches(0);
+    std::vector<std::thread> threads;
+
+    // Four tasks at two priorities, two of them sharing channel 3
+    const uint8_t channels[] = {3, 3, 7, 12};
+    const uint8_t priorities[] = {1, 1, 0, 2};
+    for (uint8_t t = 0; t < 4; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < 2000; i++) {
+                MUXLib::MUXLease lease = arbiter.acquire(channels[t], priorities[t]);
+                if (!lease) continue;
+                delayMicroseconds(5);
+                if (analogRead(SIGNAL_PIN) != channels[t] * 64) mismatches++;
+                reads++;
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    printf("reads=%u mismatches=%u switches=%u shared=%u\n",
+           (unsigned)reads, (unsigned)mismatches,
+           (unsigned)arbiter.getSwitchCount(), (unsigned)arbiter.getSharedCount());
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+// Routed I2C transfers on the host: the same sensor address sits behind
+// four TCA9548A channels. An interleaved request list is run once with a
+// select for every access and once through transferAll(), and the number
+// of select writes is compared. Finally a scan is started to check that
+// it does not change the routing until update() selects a channel.
+//
+//   g++ -std=c++11 -pthread -Iextras/host -Isrc
+//       extras/host/examples/routed_i2c.cpp src/MUXLib.cpp
+#include <Arduino.h>
+#include <Wire.h>
+#include <MUXLib.h>
+#include <I2CMUX.h>
+
+// The mux: counts select writes, remembers the routed channel
+struct MuxModel : HostSim::I2CDevice {
+    uint8_t control = 0;
+    uint32_t selects = 0;
+
+    bool write(const uint8_t* data, size_t length) override {
+        if (length) {
+            control = data[length - 1];
+            selects++;
+        }
+        return true;
+    }
+
+    size_t read(uint8_t* buffer, size_t length) override {
+        memset(buffer, control, length);
+        return length;
+    }
+};
+
+static MuxModel muxModel;
+
+// A sensor at 0x48 on every channel; register n reads back channel * 16 + n
+struct SensorModel : HostSim::I2CDevice {
+    uint8_t reg = 0;
+
+    static uint8_t channel() {
+        for (uint8_t ch = 0; ch < 8; ch++) {
+            if (muxModel.control == (1 << ch)) return ch;
+        }
+        return 0xFF;
+    }
+
+    bool write(const uint8_t* data, size_t length) override {
+        if (length) reg = data[0];
+        return channel() != 0xFF;
+    }
+
+    size_t read(uint8_t* buffer, size_t length) override {
+        for (size_t i = 0; i < length; i++) {
+            buffer[i] = channel() * 16 + reg + i;
+        }
+        return length;
+    }
+};
+
+static SensorModel sensorModel;
+
+static const uint8_t SENSOR = 0x48;
+static const uint8_t CHANNELS[] = {3, 0, 5, 0, 3, 6, 5, 6, 0, 3};
+static const uint8_t COUNT = sizeof(CHANNELS);
+
+int main() {
+    HostSim::attachI2CDevice(0x70, &muxModel);
+    HostSim::attachI2CDevice(SENSOR, &sensorModel);
+
+    MUXLib::TCA9548A mux(0x70, &Wire);
+    mux.begin();
+    int failures = 0;
+
+    // Ad hoc: select, then read, for every access
+    uint32_t before = muxModel.selects;
+    for (uint8_t i = 0; i < COUNT; i++) {
+        uint8_t value[2];
+        mux.setChannel(CHANNELS[i]);
+        Wire.beginTransmission(SENSOR);
+        Wire.write((uint8_t)(i & 1));
+        Wire.endTransmission(false);
+        Wire.requestFrom(SENSOR, (uint8_t)2);
+        value[0] = Wire.read();
+        value[1] = Wire.read();
+        if (value[0] != CHANNELS[i] * 16 + (i & 1)) failures++;
+    }
+    uint32_t adHoc = muxModel.selects - before;
+
+    // Batched: one select per channel in the list, except channel 3,
+    // which is still routed from the last ad hoc access
+    uint8_t regs[COUNT];
+    uint8_t values[COUNT][2];
+    MUXLib::I2CRequest requests[COUNT];
+    for (uint8_t i = 0; i < COUNT; i++) {
+        regs[i] = i & 1;
+        requests[i] = { CHANNELS[i], SENSOR, &regs[i], 1, values[i], 2, MUXLib::MUXStatus::OK };
+    }
+    before = muxModel.selects;
+    failures += mux.transferAll(requests, COUNT);
+    uint32_t batched = muxModel.selects - before;
+    for (uint8_t i = 0; i < COUNT; i++) {
+        if (values[i][0] != CHANNELS[i] * 16 + regs[i]) failures++;
+    }
+
+    // A driver holding a route; the second read needs no select
+    MUXLib::I2CRoute sensor(mux, 5, SENSOR);
+    uint8_t value;
+    before = muxModel.selects;
+    sensor.read(0, &value, 1);
+    sensor.read(1, &value, 1);
+    uint32_t routed = muxModel.selects - before;
+    if (value != 5 * 16 + 1) failures++;
+
+    // Scanning: transfers between update() calls still reach the channel
+    // they name, and each update() routes the next scan channel
+    mux.setChannel(1);
+    mux.setScanInterval(0);
+    mux.startScan(3, 5);
+    if (mux.readFrom(2, SENSOR, 0, &value, 1) != MUXLib::MUXStatus::OK || value != 2 * 16) failures++;
+    for (uint8_t ch = 3; ch <= 6; ch++) {
+        uint8_t expected = ch > 5 ? 3 : ch;
+        mux.update();
+        if (mux.getChannel() != expected || muxModel.control != (1 << expected)) failures++;
+        if (mux.readFrom(expected, SENSOR, 1, &value, 1) != MUXLib::MUXStatus::OK ||
+            value != expected * 16 + 1) {
+            failures++;
+        }
+    }
+    mux.stopScan();
+
+    printf("%u accesses: %u selects ad hoc, %u batched, route %u, %d failures\n",
+           COUNT, (unsigned)adHoc, (unsigned)batched, (unsigned)routed, failures);
+    return (failures == 0 && batched == 3 && routed == 1) ? 0 : 1;
+}
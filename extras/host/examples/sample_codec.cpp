@@ -0,0 +1,88 @@
+// Sample encoding on the host: slowly drifting 12-bit sensors on an HC4067
+// are swept, encoded eight sweeps to a frame, pushed through a byte stream
+// that corrupts one byte, and decoded again. Prints the stream size against
+// 16-bit words and text.
+//
+//   g++ -std=c++11 -pthread -Iextras/host -Isrc
+//       extras/host/examples/sample_codec.cpp src/MUXLib.cpp
+//
+// Pass a file name to also save the stream for extras/tools/muxsamples.py.
+#include <Arduino.h>
+#include <MUXLib.h>
+#include <AnalogMUX.h>
+#include <SampleCodec.h>
+
+static uint8_t selectPins[] = {2, 3, 4, 5};
+static const uint8_t SIGNAL_PIN = 14;
+static const uint8_t CHANNELS = 16;
+static const uint16_t SWEEPS = 512;
+
+static uint16_t encoderState[CHANNELS];
+static uint8_t encoderFrame[128];
+static uint16_t decoderState[CHANNELS];
+static uint8_t decoderFrame[128];
+static uint32_t decodedSweeps = 0;
+
+static void countSweep(uint8_t firstChannel, uint8_t count, const uint16_t* values) {
+    decodedSweeps++;
+}
+
+int main(int argc, char** argv) {
+    FILE* out = argc > 1 ? fopen(argv[1], "wb") : nullptr;
+    MUXLib::HC4067 mux(selectPins, SIGNAL_PIN);
+    mux.begin();
+
+    MUXLib::SampleEncoder encoder(encoderState, CHANNELS, encoderFrame, sizeof(encoderFrame));
+    encoder.setSweepsPerFrame(8);
+    MUXLib::SampleDecoder decoder(decoderState, CHANNELS, decoderFrame, sizeof(decoderFrame));
+    decoder.onSweep(countSweep);
+
+    uint32_t level[CHANNELS];
+    for (uint8_t ch = 0; ch < CHANNELS; ch++) level[ch] = 400 + ch * 200;
+    srand(1);
+
+    uint32_t encoded = 0, textBytes = 0, frames = 0, mismatches = 0;
+    for (uint16_t sweep = 0; sweep < SWEEPS; sweep++) {
+        uint16_t values[CHANNELS];
+        for (uint8_t ch = 0; ch < CHANNELS; ch++) {
+            level[ch] += rand() % 5 - 2;    // Slow drift plus noise
+            HostSim::setAnalog(SIGNAL_PIN, level[ch] & 0x0FFF);
+            values[ch] = mux.readChannel(ch);
+            textBytes += snprintf(nullptr, 0, "%u,", values[ch]);
+        }
+        
+        uint8_t length;
+        if (encoder.encode(values, CHANNELS, length) != MUXLib::MUXStatus::OK) {
+            printf("sweep %u rejected\n", sweep);
+            return 1;
+        }
+        if (!length) continue;
+        if (out) fwrite(encoder.getFrame(), 1, length, out);
+        encoded += length;
+        
+        // The link corrupts one byte of frame 12
+        uint8_t frame[128];
+        memcpy(frame, encoder.getFrame(), length);
+        if (frames++ == 12) frame[length / 2] ^= 0x10;
+        
+        for (uint8_t i = 0; i < length; i++) {
+            if (!decoder.feed(frame[i])) continue;
+            for (uint8_t ch = 0; ch < CHANNELS; ch++) {
+                if (decoder.getValue(ch) != values[ch]) mismatches++;
+            }
+        }
+    }
+    if (out) fclose(out);
+
+    uint32_t words = (uint32_t)SWEEPS * CHANNELS * 2;
+    printf("%u sweeps in %u frames: %u bytes, %u as 16-bit words (%.1fx), %u as text (%.1fx)\n",
+           SWEEPS, (unsigned)frames, (unsigned)encoded, (unsigned)words, (double)words / encoded,
+           (unsigned)textBytes, (double)textBytes / encoded);
+    printf("decoded %u sweeps, %u frames lost, %u bad, %u mismatches\n", (unsigned)decodedSweeps,
+           decoder.getLostFrames(), decoder.getFrameErrors(), (unsigned)mismatches);
+           
+    // Frame 12 is dropped, and the delta frames after it wait for a keyframe
+    bool ok = mismatches == 0 && decoder.getFrameErrors() > 0 && decodedSweeps < SWEEPS &&
+              decodedSweeps >= SWEEPS - 32 * 8 && encoded * 3 < words;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,81 @@
+// Switch matrix checks on the host: routes every X line of an MT8816 and
+// compares the latched AX code with the datasheet decoding, then makes sure
+// a MUXArrayMatrix refuses two inputs on one output and muxes that cannot
+// be disconnected.
+//
+//   g++ -std=c++11 -pthread -Iextras/host -Isrc
+//       extras/host/examples/switch_matrix.cpp src/MUXLib.cpp
+#include <Arduino.h>
+#include <MUXLib.h>
+#include <AnalogMUX.h>
+#include <SwitchMatrix.h>
+
+using namespace MUXLib;
+
+static uint8_t axPins[] = {2, 3, 4, 5};
+static uint8_t ayPins[] = {6, 7, 8};
+static const uint8_t DATA_PIN = 9;
+static const uint8_t STROBE_PIN = 10;
+
+// AX code of X0-X15 (MT8816 address decode truth table)
+static const uint8_t AX_CODE[16] = {0, 1, 2, 3, 4, 5, 8, 9, 10, 11, 12, 13, 6, 7, 14, 15};
+
+static int latchedCode = -1;
+
+// Record the AX code of every crosspoint closed by a STROBE pulse
+static void onPin(uint8_t pin, uint8_t level) {
+    if (pin != STROBE_PIN || level != HIGH || !HostSim::getLevel(DATA_PIN)) return;
+    latchedCode = 0;
+    for (uint8_t i = 0; i < 4; i++) latchedCode |= HostSim::getLevel(axPins[i]) << i;
+}
+
+int main() {
+    int failures = 0;
+
+    MT8816 matrix(axPins, ayPins, DATA_PIN, STROBE_PIN);
+    if (matrix.begin() != MUXStatus::OK) return 1;
+    HostSim::pinListener() = onPin;
+
+    for (uint8_t x = 0; x < 16; x++) {
+        latchedCode = -1;
+        matrix.clear();
+        matrix.connect(x, 0);
+        if (matrix.apply() != MUXStatus::OK || latchedCode != AX_CODE[x]) {
+            printf("X%u: AX code %d, expected %u\n", x, latchedCode, AX_CODE[x]);
+            failures++;
+        }
+    }
+    HostSim::pinListener() = nullptr;
+    printf("MT8816: %d of 16 X lines mis-addressed\n", failures);
+
+    // One mux per output carries a single input, so a target with two
+    // inputs on output 0 must be refused before any mux is touched
+    static uint8_t selectC[] = {40, 41, 42};
+    static uint8_t selectD[] = {43, 44, 45};
+    HC4051 sinkA(selectC, 50, 51);
+    HC4051 sinkB(selectD, 52, 53);
+    AnalogMUX* sinks[] = {&sinkA, &sinkB};
+    MUXArrayMatrix routing(sinks, 8, 2);
+    routing.begin();
+    uint8_t doubled[2] = {0x03, 0x00};      // Inputs 0 and 1 on output 0
+    if (routing.setTarget(doubled) != MUXStatus::ERROR_CHANNEL_INVALID ||
+        routing.pendingOperations() != 0 || routing.apply() != MUXStatus::OK ||
+        routing.isConnected(0, 0) || routing.isConnected(1, 0)) {
+        printf("MUXArrayMatrix accepted two inputs on one output\n");
+        failures++;
+    }
+
+    // Without EN a mux cannot open its output, so begin() must fail
+    static uint8_t selectA[] = {20, 21, 22};
+    static uint8_t selectB[] = {23, 24, 25};
+    HC4051 withEnable(selectA, 30, 31);
+    HC4051 withoutEnable(selectB, 32);
+    AnalogMUX* muxes[] = {&withEnable, &withoutEnable};
+    MUXArrayMatrix array(muxes, 8, 2);
+    if (array.begin() != MUXStatus::ERROR_INIT) {
+        printf("MUXArrayMatrix accepted a mux without an enable pin\n");
+        failures++;
+    }
+
+    return failures ? 1 : 0;
+}
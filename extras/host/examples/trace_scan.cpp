@@ -0,0 +1,50 @@
+// Host build of the trace recorder: scans an HC4067 and a TCA9548A for a
+// few cycles, then dumps the trace to stdout for extras/tools/muxtrace.py.
+//
+//   g++ -std=c++11 -pthread -DMUXLIB_ENABLE_TRACE=1 -Iextras/host -Isrc
+//       extras/host/examples/trace_scan.cpp src/MUXLib.cpp
+//   ./a.out > trace.bin && python3 extras/tools/muxtrace.py trace.bin
+//
+// Pass "hex" to get the serial monitor text format instead. The flag must
+// reach src/MUXLib.cpp as well, so it is set on the command line.
+#include <Arduino.h>
+#include <Wire.h>
+#include <MUXLib.h>
+#include <AnalogMUX.h>
+#include <I2CMUX.h>
+
+#if !MUXLIB_ENABLE_TRACE
+    #error "Build with -DMUXLIB_ENABLE_TRACE=1"
+#endif
+
+static uint8_t selectPins[] = {2, 3, 4, 5};
+static const uint8_t SIGNAL_PIN = 14;
+
+int main(int argc, char** argv) {
+    MUXLib::HC4067 analog(selectPins, SIGNAL_PIN);
+    MUXLib::TCA9548A bus(0x70, &Wire);
+    analog.begin();
+    analog.setSettlingTime(20);
+    bus.begin();
+
+    for (uint8_t cycle = 0; cycle < 4; cycle++) {
+        MUXLib::MUXTrace::mark(1, cycle);
+        for (uint8_t ch = 0; ch < 16; ch++) {
+            HostSim::setAnalog(SIGNAL_PIN, ch * 64);
+            analog.readChannel(ch);
+        }
+        for (uint8_t ch = 0; ch < 8; ch++) {
+            bus.setChannel(ch);
+        }
+        delay(5);  // Idle time between cycles
+    }
+
+    MUXLib::MUXTrace::pause();
+    if (argc > 1 && strcmp(argv[1], "hex") == 0) {
+        MUXLib::MUXTrace::dumpHex(Serial);
+    } else {
+        MUXLib::MUXTrace::dump(Serial);
+    }
+    Serial.flush();
+    return 0;
+}
@@ -0,0 +1,413 @@
+// Linux Arduino Backend (extras/linux/Arduino.h)
+// Runs MUXLib on a Linux board. The Arduino pin number is the line offset
+// on one GPIO character device (/dev/gpiochipN, v2 uAPI), and analog pins
+// map to IIO sysfs files. The select lines of a parallel mux are requested
+// together, so a channel change is one ioctl however many lines move:
+//
+//   g++ -std=c++11 -pthread -Iextras/linux -Isrc app.cpp src/MUXLib.cpp
+//
+// Without hardware, the kernel's gpio-sim and i2c-stub modules stand in
+// for the GPIO chip and the I2C devices (see extras/linux/examples).
+#ifndef MUXLIB_LINUX_ARDUINO_H
+#define MUXLIB_LINUX_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#define MUXLIB_LINUX 1
+#define MUXLIB_HOST 1               // Hosted build: std::thread and friends available
+#define MUXLIB_GPIO_MULTI_WRITE 1   // digitalWriteMulti() below
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+// Interrupt modes, numbered apart from LOW/HIGH so that level modes can
+// be told apart and refused
+#define FALLING 2
+#define RISING 3
+#define CHANGE 4
+#define DEC 10
+#define HEX 16
+
+#define digitalPinToInterrupt(p) (p)
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+typedef uint8_t byte;
+
+namespace LinuxIO {
+    const uint16_t PIN_COUNT = 256;
+    const uint8_t MAX_REQUESTS = 64;
+    const uint8_t MAX_GROUP = 32;
+    const int NONE = -1;
+
+    // One line request: a set of lines sharing a file descriptor
+    struct Request {
+        int fd;
+        uint8_t pins[MAX_GROUP];
+        uint8_t count;
+        bool output;
+    };
+
+    struct Interrupt {
+        std::thread thread;
+        std::atomic<bool> stop;
+        void (*isr)();
+    };
+
+    struct State {
+        int chip;
+        Request requests[MAX_REQUESTS];
+        int16_t requestOf[PIN_COUNT];   // Index into requests, NONE if not held
+        uint8_t bitOf[PIN_COUNT];       // Line index within its request
+        uint8_t mode[PIN_COUNT];
+        uint8_t level[PIN_COUNT];       // Last value written to an output
+        const char* analogPath[PIN_COUNT];
+        Interrupt* interrupts[PIN_COUNT];
+        std::recursive_mutex interruptLock;
+        char consumer[32];
+        
+        State() : chip(NONE) {
+            for (uint8_t i = 0; i < MAX_REQUESTS; i++) requests[i].fd = NONE;
+            for (uint16_t p = 0; p < PIN_COUNT; p++) {
+                requestOf[p] = NONE;
+                bitOf[p] = 0;
+                mode[p] = INPUT;
+                level[p] = LOW;
+                analogPath[p] = nullptr;
+                interrupts[p] = nullptr;
+            }
+            strncpy(consumer, "muxlib", sizeof(consumer));
+        }
+    };
+
+    inline State& state() {
+        static State s;
+        return s;
+    }
+
+    // Open the GPIO chip the pin numbers refer to. Call before begin().
+    inline bool openGPIO(const char* chipPath = "/dev/gpiochip0") {
+        State& s = state();
+        if (s.chip != NONE) close(s.chip);
+        s.chip = open(chipPath, O_RDWR | O_CLOEXEC);
+        if (s.chip < 0) {
+            perror(chipPath);
+            s.chip = NONE;
+            return false;
+        }
+        return true;
+    }
+
+    // Serve analogRead(pin) from a sysfs file, e.g.
+    // "/sys/bus/iio/devices/iio:device0/in_voltage0_raw"
+    inline void mapAnalog(uint8_t pin, const char* path) { state().analogPath[pin] = path; }
+
+    inline uint64_t lineFlags(uint8_t pinMode, int edge) {
+        uint64_t flags = (pinMode == OUTPUT) ? GPIO_V2_LINE_FLAG_OUTPUT : GPIO_V2_LINE_FLAG_INPUT;
+        if (pinMode == INPUT_PULLUP) flags |= GPIO_V2_LINE_FLAG_BIAS_PULL_UP;
+        if (edge == RISING || edge == CHANGE) flags |= GPIO_V2_LINE_FLAG_EDGE_RISING;
+        if (edge == FALLING || edge == CHANGE) flags |= GPIO_V2_LINE_FLAG_EDGE_FALLING;
+        return flags;
+    }
+
+    // Request lines as one group; outputs start at their cached levels
+    inline int request(const uint8_t* pins, uint8_t count, uint8_t pinMode, int edge = 0) {
+        State& s = state();
+        if (s.chip == NONE && !openGPIO()) return NONE;
+        
+        int slot = NONE;
+        for (uint8_t i = 0; i < MAX_REQUESTS; i++) {
+            if (s.requests[i].fd == NONE) {
+                slot = i;
+                break;
+            }
+        }
+        if (slot == NONE || count > MAX_GROUP) return NONE;
+        
+        struct gpio_v2_line_request req;
+        memset(&req, 0, sizeof(req));
+        strncpy(req.consumer, s.consumer, sizeof(req.consumer) - 1);
+        req.num_lines = count;
+        req.config.flags = lineFlags(pinMode, edge);
+        if (edge) req.event_buffer_size = 16;
+        
+        uint64_t values = 0;
+        for (uint8_t i = 0; i < count; i++) {
+            req.offsets[i] = pins[i];
+            if (s.level[pins[i]]) values |= 1ULL << i;
+        }
+        if (pinMode == OUTPUT) {
+            req.config.num_attrs = 1;
+            req.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+            req.config.attrs[0].attr.values = values;
+            req.config.attrs[0].mask = (count == 64) ? ~0ULL : ((1ULL << count) - 1);
+        }
+        
+        if (ioctl(s.chip, GPIO_V2_GET_LINE_IOCTL, &req) < 0) {
+            perror("GPIO_V2_GET_LINE_IOCTL");
+            return NONE;
+        }
+        
+        Request& r = s.requests[slot];
+        r.fd = req.fd;
+        r.count = count;
+        r.output = (pinMode == OUTPUT);
+        for (uint8_t i = 0; i < count; i++) {
+            r.pins[i] = pins[i];
+            s.requestOf[pins[i]] = slot;
+            s.bitOf[pins[i]] = i;
+        }
+        return slot;
+    }
+
+    // Give a pin back to the kernel. Other lines of its group stay held
+    // and keep their levels.
+    inline void release(uint8_t pin) {
+        State& s = state();
+        int slot = s.requestOf[pin];
+        if (slot == NONE) return;
+        
+        Request& r = s.requests[slot];
+        uint8_t rest[MAX_GROUP];
+        uint8_t restCount = 0;
+        for (uint8_t i = 0; i < r.count; i++) {
+            if (r.pins[i] != pin) rest[restCount++] = r.pins[i];
+            s.requestOf[r.pins[i]] = NONE;
+        }
+        bool output = r.output;
+        close(r.fd);
+        r.fd = NONE;
+        
+        if (restCount) request(rest, restCount, output ? OUTPUT : INPUT);
+    }
+
+    inline bool setValues(int slot, uint64_t bits, uint64_t mask) {
+        struct gpio_v2_line_values values;
+        values.bits = bits;
+        values.mask = mask;
+        return ioctl(state().requests[slot].fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &values) == 0;
+    }
+
+    // The pins are exactly one output group, in this order
+    inline bool isGroup(const uint8_t* pins, uint8_t count) {
+        State& s = state();
+        int slot = s.requestOf[pins[0]];
+        if (slot == NONE || s.requests[slot].count != count || !s.requests[slot].output) return false;
+        for (uint8_t i = 0; i < count; i++) {
+            if (s.requestOf[pins[i]] != slot || s.bitOf[pins[i]] != i) return false;
+        }
+        return true;
+    }
+
+    inline void dispatch(uint8_t pin) {
+        State& s = state();
+        Interrupt* irq = s.interrupts[pin];
+        int fd = s.requests[s.requestOf[pin]].fd;
+        
+        while (!irq->stop) {
+            struct pollfd waiter = { fd, POLLIN, 0 };
+            if (poll(&waiter, 1, 100) <= 0) continue;
+            
+            struct gpio_v2_line_event event;
+            if (read(fd, &event, sizeof(event)) != (ssize_t)sizeof(event)) continue;
+            
+            std::lock_guard<std::recursive_mutex> guard(s.interruptLock);
+            irq->isr();
+        }
+    }
+}
+
+inline void pinMode(uint8_t pin, uint8_t mode) {
+    LinuxIO::State& s = LinuxIO::state();
+    if (mode == INPUT_PULLUP) s.level[pin] = HIGH;
+    if (s.requestOf[pin] != LinuxIO::NONE && s.mode[pin] == mode) return;
+
+    LinuxIO::release(pin);
+    s.mode[pin] = mode;
+    LinuxIO::request(&pin, 1, mode);
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t value) {
+    LinuxIO::State& s = LinuxIO::state();
+    s.level[pin] = value ? HIGH : LOW;
+    if (s.requestOf[pin] == LinuxIO::NONE) pinMode(pin, OUTPUT);
+
+    int slot = s.requestOf[pin];
+    if (slot == LinuxIO::NONE || !s.requests[slot].output) return;
+    uint64_t bit = 1ULL << s.bitOf[pin];
+    LinuxIO::setValues(slot, value ? bit : 0, bit);
+}
+
+// Write several output pins with a single ioctl. Bit i of values/mask
+// belongs to pins[i]; pins outside the mask keep their level. The first
+// call regroups the pins into one line request.
+inline void digitalWriteMulti(const uint8_t* pins, uint8_t count, uint32_t values, uint32_t mask) {
+    LinuxIO::State& s = LinuxIO::state();
+    for (uint8_t i = 0; i < count; i++) {
+        if (mask & (1UL << i)) s.level[pins[i]] = (values >> i) & 0x01;
+    }
+
+    if (!LinuxIO::isGroup(pins, count)) {
+        for (uint8_t i = 0; i < count; i++) {
+            LinuxIO::release(pins[i]);
+            s.mode[pins[i]] = OUTPUT;
+        }
+        if (LinuxIO::request(pins, count, OUTPUT) == LinuxIO::NONE) return;
+        return;  // The request already set every line to its cached level
+    }
+    LinuxIO::setValues(s.requestOf[pins[0]], values, mask);
+}
+
+inline int digitalRead(uint8_t pin) {
+    LinuxIO::State& s = LinuxIO::state();
+    if (s.requestOf[pin] == LinuxIO::NONE) pinMode(pin, INPUT);
+
+    int slot = s.requestOf[pin];
+    if (slot == LinuxIO::NONE) return LOW;
+    if (s.requests[slot].output) return s.level[pin];
+
+    struct gpio_v2_line_values values;
+    values.bits = 0;
+    values.mask = 1ULL << s.bitOf[pin];
+    if (ioctl(s.requests[slot].fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &values) < 0) return LOW;
+    return (values.bits & values.mask) ? HIGH : LOW;
+}
+
+inline int analogRead(uint8_t pin) {
+    const char* path = LinuxIO::state().analogPath[pin];
+    if (!path) return 0;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+    char text[16];
+    ssize_t length = read(fd, text, sizeof(text) - 1);
+    close(fd);
+    if (length <= 0) return 0;
+    text[length] = '\0';
+    return atoi(text);
+}
+
+// PWM is not mapped
+inline void analogWrite(uint8_t pin, int value) {}
+
+inline uint64_t monotonicMicros() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000ULL + now.tv_nsec / 1000;
+}
+
+inline unsigned long micros() {
+    return (unsigned long)monotonicMicros();
+}
+
+inline unsigned long millis() {
+    return (unsigned long)(monotonicMicros() / 1000ULL);
+}
+
+// Short waits spin: a sleeping thread typically wakes 50 us or more late
+inline void delayMicroseconds(unsigned int us) {
+    if (us < 100) {
+        uint64_t until = monotonicMicros() + us;
+        while (monotonicMicros() < until) {}
+        return;
+    }
+    struct timespec wait = { (time_t)(us / 1000000), (long)(us % 1000000) * 1000L };
+    nanosleep(&wait, nullptr);
+}
+
+inline void delay(unsigned long ms) {
+    struct timespec wait = { (time_t)(ms / 1000), (long)(ms % 1000) * 1000000L };
+    nanosleep(&wait, nullptr);
+}
+
+inline void yield() {
+    std::this_thread::yield();
+}
+
+inline void detachInterrupt(uint8_t pin) {
+    LinuxIO::State& s = LinuxIO::state();
+    LinuxIO::Interrupt* irq = s.interrupts[pin];
+    if (!irq) return;
+
+    irq->stop = true;
+    irq->thread.join();
+    s.interrupts[pin] = nullptr;
+    delete irq;
+
+    LinuxIO::release(pin);
+    LinuxIO::request(&pin, 1, s.mode[pin]);
+}
+
+// Edge events are read by a thread per pin, which calls the handler with
+// the noInterrupts() lock held. The GPIO uAPI has no level-triggered
+// events, so LOW/HIGH modes are refused.
+inline void attachInterrupt(uint8_t pin, void (*isr)(), int mode) {
+    if (mode != RISING && mode != FALLING && mode != CHANGE) {
+        fprintf(stderr, "attachInterrupt: pin %u: only RISING, FALLING and CHANGE are supported\n", pin);
+        return;
+    }
+    LinuxIO::State& s = LinuxIO::state();
+    detachInterrupt(pin);
+
+    uint8_t inputMode = (s.mode[pin] == INPUT_PULLUP) ? INPUT_PULLUP : INPUT;
+    LinuxIO::release(pin);
+    if (LinuxIO::request(&pin, 1, inputMode, mode) == LinuxIO::NONE) return;
+    s.mode[pin] = inputMode;
+
+    LinuxIO::Interrupt* irq = new LinuxIO::Interrupt();
+    irq->stop = false;
+    irq->isr = isr;
+    s.interrupts[pin] = irq;
+    irq->thread = std::thread(LinuxIO::dispatch, pin);
+}
+
+// Keeps interrupt handlers out; nests like the real thing
+inline void noInterrupts() { LinuxIO::state().interruptLock.lock(); }
+inline void interrupts() { LinuxIO::state().interruptLock.unlock(); }
+
+// Serial goes to stdout
+class LinuxSerial {
+public:
+    void begin(unsigned long) {}
+    size_t write(uint8_t b) { return fwrite(&b, 1, 1, stdout); }
+    size_t write(const uint8_t* data, size_t length) { return fwrite(data, 1, length, stdout); }
+    void print(const char* s) { fputs(s, stdout); }
+    void print(char c) { fputc(c, stdout); }
+    void print(long n, int base = DEC) { printf(base == HEX ? "%lX" : "%ld", n); }
+    void print(int n, int base = DEC) { print((long)n, base); }
+    void print(unsigned long n, int base = DEC) { printf(base == HEX ? "%lX" : "%lu", n); }
+    void print(unsigned int n, int base = DEC) { print((unsigned long)n, base); }
+    void print(double d, int digits = 2) { printf("%.*f", digits, d); }
+    template <typename T> void println(T value) { print(value); println(); }
+    template <typename T> void println(T value, int format) { print(value, format); println(); }
+    void println() { fputc('\n', stdout); }
+    int available() { return 0; }
+    int read() { return -1; }
+    void flush() { fflush(stdout); }
+    explicit operator bool() const { return true; }
+};
+
+inline LinuxSerial& linuxSerial() {
+    static LinuxSerial serial;
+    return serial;
+}
+
+#define Serial linuxSerial()
+
+#endif
@@ -0,0 +1,235 @@
+// Linux Wire Backend (extras/linux/Wire.h)
+// TwoWire over /dev/i2c-N. Plain transfers map one-to-one onto I2C_RDWR
+// messages. transfer() sends a whole list of segments in one ioctl, for
+// example a mux select followed by a register read. Adapters without
+// plain I2C support (such as i2c-stub) are driven through the SMBus
+// ioctls instead.
+#ifndef MUXLIB_LINUX_WIRE_H
+#define MUXLIB_LINUX_WIRE_H
+
+#include <Arduino.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+#define MUXLIB_WIRE_TRANSFER 1  // TwoWire::transfer() below
+
+// One message of a combined transfer. 'stop' ends the transaction after
+// this segment; otherwise the next one follows with a repeated START.
+struct I2CSegment {
+    uint8_t address;
+    bool read;
+    uint8_t* data;
+    uint16_t length;
+    bool stop;
+};
+
+class TwoWire {
+private:
+    int fd;
+    uint8_t bus;
+    unsigned long functions;    // I2C_FUNCS of the adapter
+    uint8_t txAddress;
+    uint8_t txBuffer[32];
+    uint8_t txLength;
+    bool pendingWrite;          // Held back by endTransmission(false)
+    uint8_t rxBuffer[32];
+    uint8_t rxLength;
+    uint8_t rxIndex;
+    uint32_t clock;
+
+    // 0 = ACK, 2 = address NACK, 4 = other error (as endTransmission())
+    static uint8_t result(int status) {
+        if (status >= 0) return 0;
+        return (errno == ENXIO || errno == EREMOTEIO || errno == EIO) ? 2 : 4;
+    }
+
+    bool plainI2C() const { return (functions & I2C_FUNC_I2C) != 0; }
+
+    int smbus(uint8_t address, char readWrite, uint8_t command, int size, union i2c_smbus_data* data) {
+        if (ioctl(fd, I2C_SLAVE, address) < 0) return -1;
+        struct i2c_smbus_ioctl_data args;
+        args.read_write = readWrite;
+        args.command = command;
+        args.size = size;
+        args.data = data;
+        return ioctl(fd, I2C_SMBUS, &args);
+    }
+
+    // SMBus equivalent of a write (optionally followed by a read from the
+    // same address): send byte, write block, read byte data, read block
+    uint8_t smbusTransfer(const I2CSegment* segments, uint8_t count) {
+        union i2c_smbus_data data;
+        for (uint8_t i = 0; i < count; i++) {
+            const I2CSegment& s = segments[i];
+            const I2CSegment* next = (i + 1 < count) ? &segments[i + 1] : nullptr;
+            int status;
+            
+            if (!s.read && s.length == 1 && next && next->read && next->address == s.address &&
+                next->length <= I2C_SMBUS_BLOCK_MAX) {
+                // Register read
+                if (next->length == 1) {
+                    status = smbus(s.address, I2C_SMBUS_READ, s.data[0], I2C_SMBUS_BYTE_DATA, &data);
+                    next->data[0] = data.byte;
+                } else {
+                    data.block[0] = next->length;
+                    status = smbus(s.address, I2C_SMBUS_READ, s.data[0], I2C_SMBUS_I2C_BLOCK_DATA, &data);
+                    memcpy(next->data, &data.block[1], next->length);
+                }
+                i++;
+            } else if (!s.read && s.length == 0) {
+                status = smbus(s.address, I2C_SMBUS_WRITE, 0, I2C_SMBUS_QUICK, nullptr);
+            } else if (!s.read && s.length == 1) {
+                status = smbus(s.address, I2C_SMBUS_WRITE, s.data[0], I2C_SMBUS_BYTE, nullptr);
+            } else if (!s.read && s.length <= I2C_SMBUS_BLOCK_MAX + 1) {
+                data.block[0] = s.length - 1;
+                memcpy(&data.block[1], s.data + 1, s.length - 1);
+                status = smbus(s.address, I2C_SMBUS_WRITE, s.data[0], I2C_SMBUS_I2C_BLOCK_DATA, &data);
+            } else if (s.read) {
+                status = 0;
+                for (uint16_t b = 0; b < s.length && status >= 0; b++) {
+                    status = smbus(s.address, I2C_SMBUS_READ, 0, I2C_SMBUS_BYTE, &data);
+                    s.data[b] = data.byte;
+                }
+            } else {
+                errno = EMSGSIZE;
+                status = -1;
+            }
+            
+            if (status < 0) return result(status);
+        }
+        return 0;
+    }
+
+    // One I2C_RDWR per run of segments up to a STOP, unless the adapter
+    // can put a STOP inside a combined message (protocol mangling)
+    uint8_t plainTransfer(const I2CSegment* segments, uint8_t count) {
+        struct i2c_msg messages[I2C_RDWR_IOCTL_MAX_MSGS];
+        bool inlineStop = (functions & I2C_FUNC_PROTOCOL_MANGLING) != 0;
+        uint8_t first = 0;
+        
+        while (first < count) {
+            uint8_t n = 0;
+            uint8_t i = first;
+            for (; i < count && n < I2C_RDWR_IOCTL_MAX_MSGS; i++) {
+                const I2CSegment& s = segments[i];
+                messages[n].addr = s.address;
+                messages[n].flags = s.read ? I2C_M_RD : 0;
+                messages[n].len = s.length;
+                messages[n].buf = s.data;
+                n++;
+                if (s.stop && i + 1 < count) {
+                    if (!inlineStop) {
+                        i++;
+                        break;
+                    }
+                    messages[n - 1].flags |= I2C_M_STOP;
+                }
+            }
+            
+            struct i2c_rdwr_ioctl_data batch;
+            batch.msgs = messages;
+            batch.nmsgs = n;
+            uint8_t status = result(ioctl(fd, I2C_RDWR, &batch));
+            if (status) return status;
+            first = i;
+        }
+        return 0;
+    }
+
+public:
+    TwoWire(uint8_t busNumber = 1)
+        : fd(-1), bus(busNumber), functions(0), txAddress(0), txLength(0),
+          pendingWrite(false), rxLength(0), rxIndex(0), clock(100000) {}
+          
+    ~TwoWire() { end(); }
+
+    // Adapter number N of /dev/i2c-N; call before begin()
+    void setBus(uint8_t busNumber) { bus = busNumber; }
+
+    void begin() {
+        if (fd >= 0) return;
+        char path[20];
+        snprintf(path, sizeof(path), "/dev/i2c-%u", bus);
+        fd = open(path, O_RDWR | O_CLOEXEC);
+        if (fd < 0) {
+            perror(path);
+            return;
+        }
+        if (ioctl(fd, I2C_FUNCS, &functions) < 0) functions = 0;
+    }
+
+    void end() {
+        if (fd >= 0) close(fd);
+        fd = -1;
+    }
+
+    // The bus clock belongs to the kernel (device tree); kept for the API
+    void setClock(uint32_t frequency) { clock = frequency; }
+    uint32_t getClock() const { return clock; }
+
+    // Send segments back to back, returns as endTransmission()
+    uint8_t transfer(const I2CSegment* segments, uint8_t count) {
+        if (fd < 0) return 4;
+        if (count == 0) return 0;
+        return plainI2C() ? plainTransfer(segments, count) : smbusTransfer(segments, count);
+    }
+
+    void beginTransmission(uint8_t address) {
+        txAddress = address & 0x7F;
+        txLength = 0;
+    }
+
+    size_t write(uint8_t value) {
+        if (txLength >= sizeof(txBuffer)) return 0;
+        txBuffer[txLength++] = value;
+        return 1;
+    }
+
+    size_t write(const uint8_t* data, size_t length) {
+        size_t written = 0;
+        while (written < length && write(data[written])) written++;
+        return written;
+    }
+
+    // Without a STOP the write is held back and sent with the next
+    // requestFrom() as one combined transfer
+    uint8_t endTransmission(bool stop = true) {
+        if (!stop) {
+            pendingWrite = true;
+            return 0;
+        }
+        I2CSegment segment = { txAddress, false, txBuffer, txLength, true };
+        return transfer(&segment, 1);
+    }
+
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t stop = 1) {
+        address &= 0x7F;
+        rxIndex = 0;
+        rxLength = 0;
+        if (quantity > sizeof(rxBuffer)) quantity = sizeof(rxBuffer);
+        
+        I2CSegment segments[2];
+        uint8_t count = 0;
+        if (pendingWrite) {
+            segments[count++] = { txAddress, false, txBuffer, txLength, false };
+            pendingWrite = false;
+        }
+        segments[count++] = { address, true, rxBuffer, quantity, true };
+        if (transfer(segments, count) != 0) return 0;
+        
+        rxLength = quantity;
+        return rxLength;
+    }
+
+    int available() { return rxLength - rxIndex; }
+    int read() { return (rxIndex < rxLength) ? rxBuffer[rxIndex++] : -1; }
+};
+
+inline TwoWire& linuxWire() {
+    static TwoWire wire;
+    return wire;
+}
+
+#define Wire linuxWire()
+
+#endif
@@ -0,0 +1,73 @@
+// Linux build: an HC4051 on GPIO lines and a TCA9548A on an I2C adapter.
+// Every HC4051 channel change is a single line-values ioctl. Each register
+// read behind the TCA9548A is one transfer() that folds in the select
+// write when the channel changes.
+//
+//   g++ -std=c++11 -pthread -Iextras/linux -Isrc
+//       extras/linux/examples/linux_mux.cpp src/MUXLib.cpp -o linux_mux
+//
+// Without hardware (as root):
+//
+//   modprobe gpio-sim
+//   mkdir -p /sys/kernel/config/gpio-sim/muxlib/bank0
+//   echo 8 > /sys/kernel/config/gpio-sim/muxlib/bank0/num_lines
+//   echo 1 > /sys/kernel/config/gpio-sim/muxlib/live
+//   CHIP=/dev/$(cat /sys/kernel/config/gpio-sim/muxlib/bank0/chip_name)
+//
+//   modprobe i2c-dev
+//   modprobe i2c-stub chip_addr=0x70,0x48
+//   BUS=$(i2cdetect -l | awk '/SMBus stub/ { sub("i2c-", "", $1); print $1 }')
+//   i2cset -y $BUS 0x48 0x00 0x5A
+//
+//   ./linux_mux $CHIP $BUS
+//
+// i2c-stub has no routing, so 0x48 answers on every channel, and the stub
+// adapter only speaks SMBus, which exercises the SMBus fallback. A real
+// adapter gets the combined I2C_RDWR path.
+#include <Arduino.h>
+#include <Wire.h>
+#include <MUXLib.h>
+#include <AnalogMUX.h>
+#include <I2CMUX.h>
+
+static uint8_t selectPins[] = {0, 1, 2};    // Line offsets on the GPIO chip
+
+int main(int argc, char** argv) {
+    const char* chip = argc > 1 ? argv[1] : "/dev/gpiochip0";
+    uint8_t bus = argc > 2 ? atoi(argv[2]) : 1;
+    int failures = 0;
+
+    if (!LinuxIO::openGPIO(chip)) return 1;
+    MUXLib::HC4051 analog(selectPins, 255);
+    if (analog.begin() != MUXLib::MUXStatus::OK) return 1;
+
+    for (uint8_t ch = 0; ch < 8; ch++) {
+        analog.setChannel(ch);
+        uint8_t seen = 0;
+        for (uint8_t i = 0; i < 3; i++) {
+            seen |= digitalRead(selectPins[i]) << i;
+        }
+        if (seen != ch) {
+            printf("HC4051 channel %u drove %u\n", ch, seen);
+            failures++;
+        }
+    }
+
+    Wire.setBus(bus);
+    MUXLib::TCA9548A mux(0x70, &Wire);
+    if (mux.begin() != MUXLib::MUXStatus::OK) {
+        printf("no TCA9548A on /dev/i2c-%u\n", bus);
+        return 1;
+    }
+
+    const uint8_t reg = 0x00;
+    for (uint8_t ch = 0; ch < 8; ch++) {
+        uint8_t value = 0;
+        MUXLib::MUXStatus status = mux.transfer(ch, 0x48, &reg, 1, &value, 1);
+        printf("channel %u: 0x48[0x%02X] = 0x%02X%s\n", ch, reg, value,
+               status == MUXLib::MUXStatus::OK ? "" : " (failed)");
+        if (status != MUXLib::MUXStatus::OK) failures++;
+    }
+
+    return failures ? 1 : 0;
+}
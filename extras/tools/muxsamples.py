@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+"""Decode MUXLib sample streams (SampleEncoder frames, SampleCodec.h).
+
+Capture the raw bytes sent by the node into a file, then:
+
+    python3 muxsamples.py stream.bin              summary: size, ratio, errors
+    python3 muxsamples.py stream.bin --csv        one line per sweep
+
+Bytes between frames are skipped, so a capture may start mid-frame or
+contain other traffic. Use '-' to read standard input.
+"""
+
+import argparse
+import sys
+
+SYNC = 0xA5
+HEADER = 7
+OVERHEAD = HEADER + 2
+KEYFRAME = 0x80
+VARINT_SWEEP = 0x80
+
+
+def crc16(data):
+    """CRC-16/MODBUS, as Utility::calculateCRC()."""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+
+def unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+def read_sweep(payload, pos, count):
+    """Zig-zag values of one sweep and the position after it."""
+    tag = payload[pos]
+    pos += 1
+    values = []
+    if tag == VARINT_SWEEP:
+        for _ in range(count):
+            value, shift = 0, 0
+            while True:
+                byte = payload[pos]
+                pos += 1
+                value |= (byte & 0x7F) << shift
+                shift += 7
+                if not byte & 0x80:
+                    break
+            values.append(value)
+    elif tag <= 16:
+        bits, available = 0, 0
+        for _ in range(count):
+            while available < tag:
+                bits |= payload[pos] << available
+                pos += 1
+                available += 8
+            values.append(bits & ((1 << tag) - 1))
+            bits >>= tag
+            available -= tag
+    else:
+        raise ValueError("bad sweep tag 0x%02X" % tag)
+    return values, pos
+
+
+class Decoder(object):
+    def __init__(self):
+        self.values = {}
+        self.synced = False
+        self.expected = None
+        self.frames = 0
+        self.bad = 0
+        self.lost = 0
+        self.skipped = 0
+
+    def frames_in(self, data):
+        """Yield the valid frames in a byte string, resynchronising on errors."""
+        pos = 0
+        while pos + OVERHEAD <= len(data):
+            if data[pos] != SYNC:
+                pos += 1
+                continue
+            end = pos + OVERHEAD + data[pos + 6]
+            frame = data[pos:end]
+            if len(frame) < end - pos:
+                break
+            if crc16(frame[:-2]) != frame[-2] | frame[-1] << 8:
+                self.bad += 1
+                pos += 1
+                continue
+            yield frame
+            pos = end
+
+    def decode(self, frame):
+        """Sweeps of one frame as (sequence, first channel, values)."""
+        sequence = frame[2]
+        if self.expected is not None and sequence != self.expected:
+            self.lost += (sequence - self.expected) & 0xFF
+            self.synced = False
+        self.expected = (sequence + 1) & 0xFF
+        self.frames += 1
+
+        key = bool(frame[1] & KEYFRAME)
+        first, count, sweeps = frame[3], frame[4], frame[5]
+        if not key and not self.synced:
+            self.skipped += sweeps
+            return []
+
+        payload = frame[HEADER:-2]
+        pos = 0
+        out = []
+        try:
+            for sweep in range(sweeps):
+                deltas, pos = read_sweep(payload, pos, count)
+                for i, z in enumerate(deltas):
+                    base = 0 if key and sweep == 0 else self.values.get(first + i, 0)
+                    self.values[first + i] = (base + unzigzag(z)) & 0xFFFF
+                out.append((sequence, first, [self.values[first + i] for i in range(count)]))
+        except (IndexError, ValueError):
+            self.bad += 1
+            self.synced = False
+            return out
+        self.synced = True
+        return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("stream", help="file holding SampleEncoder frames, '-' for stdin")
+    parser.add_argument("--csv", action="store_true", help="print sequence, first channel and values per sweep")
+    args = parser.parse_args()
+
+    if args.stream == "-":
+        data = sys.stdin.buffer.read() if hasattr(sys.stdin, "buffer") else sys.stdin.read()
+    else:
+        with open(args.stream, "rb") as source:
+            data = source.read()
+    data = bytearray(data)
+
+    decoder = Decoder()
+    sweeps = 0
+    samples = 0
+    for frame in decoder.frames_in(data):
+        for sequence, first, values in decoder.decode(frame):
+            sweeps += 1
+            samples += len(values)
+            if args.csv:
+                print(",".join(str(v) for v in [sequence, first] + values))
+
+    if not args.csv:
+        print("%d bytes, %d frames, %d sweeps, %d samples" % (len(data), decoder.frames, sweeps, samples))
+        if samples:
+            print("%.2f bytes per sample, %.1fx smaller than 16-bit words" %
+                  (len(data) / float(samples), samples * 2.0 / max(len(data), 1)))
+        print("%d bad frames, %d lost frames, %d sweeps waiting for a keyframe" %
+              (decoder.bad, decoder.lost, decoder.skipped))
+
+
+if __name__ == "__main__":
+    main()
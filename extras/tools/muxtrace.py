@@ -0,0 +1,243 @@
+#!/usr/bin/env python3
+"""Decode and analyse MUXLib traces (MUXLIB_ENABLE_TRACE).
+
+Capture the output of MUXTrace::dump() (binary) or MUXTrace::dumpHex()
+(text, e.g. copied from a serial monitor) into a file, then:
+
+    python3 muxtrace.py trace.bin                 summary per MUX and channel
+    python3 muxtrace.py trace.txt --events        every decoded event
+    python3 muxtrace.py trace.bin --timeline 0    channel timeline of MUX 0
+    python3 muxtrace.py trace.bin --gap-us 500    report idle gaps over 500 us
+
+Use '-' to read standard input.
+"""
+
+import argparse
+import struct
+import sys
+from collections import defaultdict
+
+OPS = ["GAP", "SWITCH", "SAMPLE", "SETTLE", "I2C", "MARK"]
+GAP, SWITCH, SAMPLE, SETTLE, I2C, MARK = range(len(OPS))
+APPLICATION = 255
+
+HEADER = struct.Struct("<4sBBHII")
+EVENT = struct.Struct("<HBBBBH")
+
+
+class Event(object):
+    __slots__ = ("time", "instance", "op", "channel", "status", "value")
+
+    def __init__(self, time, instance, op, channel, status, value):
+        self.time = time
+        self.instance = instance
+        self.op = op
+        self.channel = channel
+        self.status = status
+        self.value = value
+
+    def describe(self):
+        op = OPS[self.op] if self.op < len(OPS) else "OP%d" % self.op
+        who = "app" if self.instance == APPLICATION else "mux%d" % self.instance
+        if self.op == I2C:
+            kind = "read" if self.channel & 0x80 else "write"
+            detail = "%s 0x%02X status=%d %dus" % (kind, self.channel & 0x7F, self.status, self.value)
+        elif self.op == SWITCH:
+            detail = "ch%d %dus" % (self.channel, self.value)
+            if self.status:
+                detail += " failed status=%d" % self.status
+        elif self.op == SETTLE:
+            detail = "ch%d %dus" % (self.channel, self.value)
+        elif self.op == SAMPLE:
+            detail = "ch%d value=%d" % (self.channel, self.value)
+        elif self.op == MARK:
+            detail = "tag=%d value=%d" % (self.channel, self.value)
+        else:
+            detail = "channel=%d status=%d value=%d" % (self.channel, self.status, self.value)
+        return "%12d  %-5s %-6s %s" % (self.time, who, op, detail)
+
+
+def extract(data):
+    """Binary trace bytes from a raw dump or a hex text dump."""
+    if data[:4] == b"MXTR":
+        return data
+    text = data.decode("ascii", "replace")
+    hex_digits = []
+    inside = False
+    for line in text.splitlines():
+        line = line.strip()
+        if line == "#MXTR-BEGIN":
+            inside = True
+            hex_digits = []
+        elif line == "#MXTR-END":
+            break
+        elif inside:
+            hex_digits.append(line)
+    if not hex_digits:
+        raise ValueError("no MUXLib trace found")
+    return bytes(bytearray.fromhex("".join(hex_digits)))
+
+
+def parse(data):
+    data = extract(data)
+    if len(data) < HEADER.size:
+        raise ValueError("trace too short")
+    magic, version, size, count, overwritten, last_micros = HEADER.unpack_from(data, 0)
+    if magic != b"MXTR" or version != 1 or size != EVENT.size:
+        raise ValueError("unsupported trace format (version %d, event size %d)" % (version, size))
+    if len(data) < HEADER.size + count * EVENT.size:
+        raise ValueError("trace truncated: %d of %d events" % ((len(data) - HEADER.size) // EVENT.size, count))
+
+    events = []
+    time = 0
+    pending = 0  # GAP extension carried into the next event
+    for i in range(count):
+        delta, instance, op, channel, status, value = EVENT.unpack_from(data, HEADER.size + i * EVENT.size)
+        if i > 0:
+            time += delta + pending
+        pending = 0
+        if op == GAP:
+            pending = value << 16
+            continue
+        events.append(Event(time, instance, op, channel, status, value))
+
+    # Anchor on the device clock: the newest event happened at last_micros
+    if events:
+        shift = (last_micros - events[-1].time) & 0xFFFFFFFF
+        for event in events:
+            event.time += shift
+    return events, overwritten
+
+
+def percent(part, whole):
+    return 100.0 * part / whole if whole else 0.0
+
+
+def summarize(events, overwritten, gap_us, top):
+    if not events:
+        print("empty trace")
+        return
+    span = events[-1].time - events[0].time
+    print("%d events over %.3f ms%s" % (len(events), span / 1000.0,
+          " (%d older events overwritten)" % overwritten if overwritten else ""))
+
+    by_instance = defaultdict(list)
+    for event in events:
+        by_instance[event.instance].append(event)
+
+    for instance in sorted(by_instance):
+        if instance == APPLICATION:
+            continue
+        stream = by_instance[instance]
+        switches = [e for e in stream if e.op == SWITCH]
+        failed = sum(1 for e in switches if e.status)
+        settles = [e for e in stream if e.op == SETTLE]
+        samples = [e for e in stream if e.op == SAMPLE]
+        transfers = [e for e in stream if e.op == I2C]
+
+        switch_time = sum(e.value for e in switches)
+        settle_time = sum(e.value for e in settles)
+        print()
+        print("mux%d" % instance)
+        if switches:
+            rate = len(switches) * 1e6 / span if span else 0.0
+            print("  switches     %6d  %.1f/s  mean %.1f us  max %d us  (%.1f%% of time)%s" % (
+                len(switches), rate, switch_time / float(len(switches)),
+                max(e.value for e in switches), percent(switch_time, span),
+                "  %d failed" % failed if failed else ""))
+        if settles:
+            print("  settling     %6d  total %d us  (%.1f%% of time)" % (
+                len(settles), settle_time, percent(settle_time, span)))
+        if samples:
+            print("  samples      %6d" % len(samples))
+        if transfers:
+            errors = sum(1 for e in transfers if e.status)
+            bus_time = sum(e.value for e in transfers)
+            print("  i2c          %6d  %d failed  total %d us  (%.1f%% of time)" % (
+                len(transfers), errors, bus_time, percent(bus_time, span)))
+
+        dwell = channel_dwell(stream, events[-1].time)
+        if dwell:
+            print("  channel  selects   dwell us   share")
+            for channel in sorted(dwell):
+                selects, total = dwell[channel]
+                print("  %7d  %7d  %9d  %5.1f%%" % (channel, selects, total, percent(total, span)))
+
+    gaps = idle_gaps(events, gap_us)
+    if gaps:
+        print()
+        print("idle gaps over %d us: %d, %d us in total (%.1f%% of time)" % (
+            gap_us, len(gaps), sum(g[0] for g in gaps), percent(sum(g[0] for g in gaps), span)))
+        for length, before, after in sorted(gaps, key=lambda g: -g[0])[:top]:
+            print("  %8d us after:  %s" % (length, before.describe().strip()))
+            print("  %8s    before: %s" % ("", after.describe().strip()))
+
+
+def channel_dwell(stream, end):
+    """selects and time spent per channel, from one MUX's successful SWITCH events"""
+    dwell = {}
+    switches = [e for e in stream if e.op == SWITCH and not e.status]
+    for current, following in zip(switches, switches[1:] + [None]):
+        until = following.time - following.value if following else end
+        selects, total = dwell.get(current.channel, (0, 0))
+        dwell[current.channel] = (selects + 1, total + max(0, until - current.time))
+    return dwell
+
+
+def idle_gaps(events, gap_us):
+    """Stretches with no library activity; the start of an event is its
+    time minus its duration"""
+    gaps = []
+    for before, after in zip(events, events[1:]):
+        start = after.time
+        if after.op in (SWITCH, SETTLE, I2C):
+            start -= after.value
+        length = start - before.time
+        if length > gap_us:
+            gaps.append((length, before, after))
+    return gaps
+
+
+def timeline(events, instance):
+    switches = [e for e in events if e.instance == instance and e.op == SWITCH and not e.status]
+    if not switches:
+        print("no switches recorded for mux%d" % instance)
+        return
+    end = events[-1].time
+    print("%12s  %7s  %9s" % ("time us", "channel", "dwell us"))
+    for current, following in zip(switches, switches[1:] + [None]):
+        until = following.time - following.value if following else end
+        print("%12d  %7d  %9d" % (current.time, current.channel, until - current.time))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("trace", help="file holding a MUXTrace dump, '-' for stdin")
+    parser.add_argument("--events", action="store_true", help="print every event")
+    parser.add_argument("--timeline", type=int, metavar="MUX", help="channel timeline of one MUX")
+    parser.add_argument("--gap-us", type=int, default=1000, help="idle gap threshold (default 1000)")
+    parser.add_argument("--top", type=int, default=5, help="idle gaps to list (default 5)")
+    args = parser.parse_args()
+
+    if args.trace == "-":
+        data = sys.stdin.buffer.read() if hasattr(sys.stdin, "buffer") else sys.stdin.read()
+    else:
+        with open(args.trace, "rb") as source:
+            data = source.read()
+
+    try:
+        events, overwritten = parse(data)
+    except ValueError as error:
+        sys.exit("muxtrace: %s" % error)
+
+    if args.events:
+        for event in events:
+            print(event.describe())
+    elif args.timeline is not None:
+        timeline(events, args.timeline)
+    else:
+        summarize(events, overwritten, args.gap_us, args.top)
+
+
+if __name__ == "__main__":
+    main()
@@ -5,29 +5,91 @@
 #include "MUXLib.h"
 
 namespace MUXLib {
+    // ChipDescriptor flags
+    const uint8_t CHIP_ENABLE_HIGH = 0x01;          // EN is active HIGH (default active LOW)
+    const uint8_t CHIP_BREAK_BEFORE_MAKE = 0x02;    // Drop EN around every switch
+    const uint8_t CHIP_STROBE = 0x04;               // Address latched by an active LOW strobe
+    const uint8_t CHIP_SWAP_A0_A1 = 0x08;           // A0/A1 swapped against the channel number
+
+    // How a parallel-addressed analog mux switches. The generic engine in
+    // AnalogMUX::setChannel() runs every part from one of these, so a new
+    // chip needs a descriptor rather than a class.
+    struct ChipDescriptor {
+        uint8_t selectPins;
+        uint8_t flags;
+        uint8_t pulseMicros;    // Strobe width and break-before-make gap
+        uint16_t settleMicros;  // Default settling time
+    };
+
+    constexpr ChipDescriptor CHIP_HC4051   = {3, CHIP_BREAK_BEFORE_MAKE, 1, 10};
+    constexpr ChipDescriptor CHIP_HC4067   = {4, CHIP_BREAK_BEFORE_MAKE, 1, 10};
+    constexpr ChipDescriptor CHIP_HC4052   = {2, CHIP_BREAK_BEFORE_MAKE, 1, 10};
+    constexpr ChipDescriptor CHIP_HC4053   = {3, CHIP_BREAK_BEFORE_MAKE, 1, 10};
+    constexpr ChipDescriptor CHIP_ADG508A  = {3, CHIP_ENABLE_HIGH | CHIP_BREAK_BEFORE_MAKE, 1, 10};
+    constexpr ChipDescriptor CHIP_ADG706   = {4, CHIP_ENABLE_HIGH | CHIP_STROBE, 1, 10};
+    constexpr ChipDescriptor CHIP_ADG506A  = {4, CHIP_ENABLE_HIGH | CHIP_BREAK_BEFORE_MAKE, 1, 10};
+    constexpr ChipDescriptor CHIP_ADG507A  = {3, CHIP_ENABLE_HIGH | CHIP_BREAK_BEFORE_MAKE, 1, 10};
+    constexpr ChipDescriptor CHIP_DG408    = {3, CHIP_ENABLE_HIGH, 1, 150};
+    constexpr ChipDescriptor CHIP_DG409    = {3, CHIP_ENABLE_HIGH | CHIP_SWAP_A0_A1, 1, 150};
+    constexpr ChipDescriptor CHIP_MAX4051A = {3, CHIP_BREAK_BEFORE_MAKE, 1, 5};
+    constexpr ChipDescriptor CHIP_MAX4582  = {3, CHIP_STROBE, 1, 15};
+
     // Base class for analog multiplexers
     class AnalogMUX : public MUXManager {
     protected:
+        ChipDescriptor chip;
         uint8_t* selectPins;
         uint8_t numSelectPins;
         uint8_t enablePin;
         uint8_t signalPin;
+        uint8_t strobePin;
         uint16_t settlingTime;  // microseconds
         
+        // Logical channel -> select pin pattern, resolved once by begin()
+        uint8_t* channelMap;    // Optional logical -> physical remap
+        uint8_t* selectTable;
+        uint8_t selectState;    // Pattern currently driven on the select pins
+        uint8_t settledChannel; // Read by readChannel() and untouched since, 255 = none
+        
+        // Known reference input used by runSelfTest()
+        uint8_t referenceChannel;
+        uint16_t referenceValue;
+        uint16_t referenceTolerance;
+        
+        void driveEnable(bool on) {
+            if (enablePin != 255) {
+                digitalWrite(enablePin, on == ((chip.flags & CHIP_ENABLE_HIGH) != 0));
+            }
+        }
+        
+        bool nearReference(uint16_t value) const {
+            int32_t error = (int32_t)value - referenceValue;
+            return error <= referenceTolerance && error >= -(int32_t)referenceTolerance;
+        }
+        
     public:
-        AnalogMUX(uint8_t* selPins, uint8_t numPins, uint8_t sigPin, uint8_t enPin = 255) 
-            : MUXManager(0, 1 << numPins), numSelectPins(numPins), 
-              enablePin(enPin), signalPin(sigPin), settlingTime(10) {
-            selectPins = (uint8_t*)malloc(numPins * sizeof(uint8_t));
+        AnalogMUX(const ChipDescriptor& desc, uint8_t* selPins, uint8_t sigPin,
+                  uint8_t enPin = 255, uint8_t strbPin = 255)
+            : MUXManager(0, 1 << desc.selectPins), chip(desc), numSelectPins(desc.selectPins),
+              enablePin(enPin), signalPin(sigPin), strobePin(strbPin), settlingTime(desc.settleMicros),
+              channelMap(nullptr), selectTable(nullptr), selectState(0), settledChannel(255),
+              referenceChannel(255), referenceValue(0), referenceTolerance(0) {
+            selectPins = (uint8_t*)malloc(numSelectPins * sizeof(uint8_t));
             if (selectPins) {
-                memcpy(selectPins, selPins, numPins * sizeof(uint8_t));
+                memcpy(selectPins, selPins, numSelectPins * sizeof(uint8_t));
             }
         }
         
+        // Plain binary-addressed part with an active LOW enable
+        AnalogMUX(uint8_t* selPins, uint8_t numPins, uint8_t sigPin, uint8_t enPin = 255) 
+            : AnalogMUX(ChipDescriptor{numPins, CHIP_BREAK_BEFORE_MAKE, 1, 10}, selPins, sigPin, enPin) {}
+        
         ~AnalogMUX() {
             if (selectPins) {
                 free(selectPins);
             }
+            if (channelMap) free(channelMap);
+            if (selectTable) free(selectTable);
         }
         
         MUXStatus begin() override {
@@ -37,10 +99,21 @@ namespace MUXLib {
                 pinMode(selectPins[i], OUTPUT);
                 digitalWrite(selectPins[i], LOW);
             }
+            selectState = 0;
+            settledChannel = 255;
+            
+            MUXStatus tableStatus = buildSelectTable();
+            if (tableStatus != MUXStatus::OK) return tableStatus;
             
             if (enablePin != 255) {
                 pinMode(enablePin, OUTPUT);
-                digitalWrite(enablePin, HIGH);  // Most analog muxes are active LOW
+                driveEnable(false);
+            }
+            
+            if (chip.flags & CHIP_STROBE) {
+                if (strobePin == 255) return MUXStatus::ERROR_INIT;
+                pinMode(strobePin, OUTPUT);
+                digitalWrite(strobePin, HIGH);
             }
             
             if (signalPin != 255) {
@@ -55,74 +128,254 @@ namespace MUXLib {
             settlingTime = microseconds;
         }
         
-        virtual uint16_t readChannel(uint8_t channel) {
-            if (setChannel(channel) != MUXStatus::OK) {
-                return 0;
+        // Remap logical channels to physical inputs (e.g. to follow PCB
+        // routing). map holds getMaxChannels() entries; nullptr restores
+        // the identity mapping.
+        MUXStatus setChannelMap(const uint8_t* map) {
+            if (!map) {
+                if (channelMap) free(channelMap);
+                channelMap = nullptr;
+                return selectTable ? buildSelectTable() : MUXStatus::OK;
             }
             
-            delayMicros(settlingTime);
-            return analogRead(signalPin);
+            for (uint8_t i = 0; i < maxChannels; i++) {
+                if (map[i] >= maxChannels) return MUXStatus::ERROR_CHANNEL_INVALID;
+            }
+            if (!channelMap) {
+                channelMap = (uint8_t*)malloc(maxChannels);
+                if (!channelMap) return MUXStatus::ERROR_INIT;
+            }
+            memcpy(channelMap, map, maxChannels);
+            return selectTable ? buildSelectTable() : MUXStatus::OK;
+        }
+        
+        // Order logical channels so that stepping through them in sequence
+        // visits the physical inputs in Gray code: one select line toggles
+        // per step. This is itself a channel map, so logical channel n no
+        // longer reads physical input n; use getPhysicalChannel() to label
+        // the results. A PCB remap would break the one-line steps, so this
+        // fails with ERROR_INIT while another map is set (clear it with
+        // setChannelMap(nullptr) first).
+        MUXStatus useGrayCodeOrder() {
+            uint8_t map[32];
+            if (maxChannels > sizeof(map)) return MUXStatus::ERROR_OVERFLOW;
+            
+            for (uint8_t i = 0; i < maxChannels; i++) {
+                map[i] = i ^ (i >> 1);
+            }
+            if (channelMap && memcmp(channelMap, map, maxChannels) != 0) return MUXStatus::ERROR_INIT;
+            return setChannelMap(map);
+        }
+        
+        uint8_t getEnablePin() const { return enablePin; }
+        
+        // True if readChannel(channel) would read without switching
+        bool isSettled(uint8_t channel) const {
+            return enabled && channel == settledChannel && channel == currentChannel;
+        }
+        
+        uint8_t getPhysicalChannel(uint8_t channel) const {
+            if (!isValidChannel(channel)) return 255;
+            return channelMap ? channelMap[channel] : channel;
+        }
+        
+        // Also open the switch; the next setChannel() after enable() closes it
+        void disable() override {
+            driveEnable(false);
+            settledChannel = 255;
+            enabled = false;
         }
-    };
-
-    // 74HC4051 - 8 channel analog multiplexer
-    class HC4051 : public AnalogMUX {
-    public:
-        HC4051(uint8_t* selPins, uint8_t sigPin, uint8_t enPin = 255)
-            : AnalogMUX(selPins, 3, sigPin, enPin) {}  // 3 select pins for 8 channels
         
+        // Switch off and drive the select lines low; the channel is kept
+        void sleep() override {
+            if (sleeping || !enabled) return;
+            
+            driveEnable(false);
+            for (uint8_t i = 0; i < numSelectPins; i++) {
+                digitalWrite(selectPins[i], LOW);
+            }
+            selectState = 0;
+            settledChannel = 255;
+            
+            enabled = false;
+            sleeping = true;
+        }
+        
+        // Re-select the channel used before sleep(). No settling delay is
+        // added here, readChannel() settles before sampling as usual.
+        void wake() override {
+            if (!sleeping) return;
+            
+            sleeping = false;
+            enabled = true;
+            setChannel(currentChannel);
+        }
+        
+        // Declare a channel wired to a known level (e.g. a divider or VCC)
+        void setReferenceChannel(uint8_t channel, uint16_t expected, uint16_t tolerance) {
+            referenceChannel = channel;
+            referenceValue = expected;
+            referenceTolerance = tolerance;
+        }
+        
+        // For every other channel: select it and check that the reading has
+        // left the reference level (a mux stuck on the reference channel
+        // fails here), then switch back and time how long the reference takes
+        // to land within tolerance. A channel fails if it reads like the
+        // reference, or if the reference never settles within 10x the
+        // configured settling time, so no other input may sit at the
+        // reference level during the test. Without a reference channel
+        // nothing is tested. The previously selected channel is restored.
+        bool runSelfTest(SelfTestResult& result) override {
+            memset(&result, 0, sizeof(result));
+            if (!isValidChannel(referenceChannel) || signalPin == 255) return true;
+            
+            uint8_t previous = currentChannel;
+            uint32_t start = micros();
+            uint32_t timeout = 10UL * settlingTime + 100;
+            
+            // One mask bit per channel
+            for (uint8_t ch = 0; ch < maxChannels && ch < 32; ch++) {
+                if (ch == referenceChannel) continue;
+                
+                if (setChannel(ch) != MUXStatus::OK) {
+                    result.failMask |= (1UL << ch);
+                    continue;
+                }
+                delayMicros(settlingTime);
+                if (nearReference(analogRead(signalPin)) ||
+                    setChannel(referenceChannel) != MUXStatus::OK) {
+                    result.failMask |= (1UL << ch);
+                    continue;
+                }
+                
+                uint32_t switched = micros();
+                uint32_t elapsed;
+                bool settled = false;
+                do {
+                    uint16_t value = analogRead(signalPin);
+                    elapsed = micros() - switched;
+                    if (nearReference(value)) {
+                        settled = true;
+                        break;
+                    }
+                } while (elapsed < timeout);
+                
+                if (settled) {
+                    result.passMask |= (1UL << ch);
+                    if (elapsed > result.settleMicros) {
+                        result.settleMicros = elapsed > 0xFFFF ? 0xFFFF : elapsed;
+                    }
+                } else {
+                    result.failMask |= (1UL << ch);
+                }
+            }
+            
+            setChannel(previous);
+            result.durationMicros = micros() - start;
+            return result.failMask == 0;
+        }
+        
+        // Generic switching engine: optional break-before-make on EN, new
+        // address on the select lines, optional strobe to latch it, EN on
         MUXStatus setChannel(uint8_t channel) override {
             if (!isValidChannel(channel)) return MUXStatus::ERROR_CHANNEL_INVALID;
             if (!enabled) return MUXStatus::ERROR_NOT_ENABLED;
+            MUXLIB_DIAG_SCOPE(setChannelHistogram);
+            MUXLIB_TRACE_SCOPE(channel);
+            MUXLIB_DIAG(diagSwitch(channel));
+            settledChannel = 255;  // Break-before-make drops EN even for the same channel
             
-            // Disable before switching (break-before-make)
-            if (enablePin != 255) {
-                digitalWrite(enablePin, HIGH);
-                delayMicros(1);
+            bool breakFirst = (chip.flags & CHIP_BREAK_BEFORE_MAKE) && enablePin != 255;
+            if (breakFirst) {
+                driveEnable(false);
+                delayMicros(chip.pulseMicros);
             }
             
-            for (uint8_t i = 0; i < 3; i++) {
-                digitalWrite(selectPins[i], (channel >> i) & 0x01);
-            }
+            writeSelect(channel);
             
-            if (enablePin != 255) {
-                delayMicros(1);
-                digitalWrite(enablePin, LOW);
+            if (chip.flags & CHIP_STROBE) {
+                digitalWrite(strobePin, LOW);
+                delayMicros(chip.pulseMicros);
+                digitalWrite(strobePin, HIGH);
             }
             
+            if (breakFirst) delayMicros(chip.pulseMicros);
+            driveEnable(true);
+            
             currentChannel = channel;
             return MUXStatus::OK;
         }
-    };
-
-    // 74HC4067 - 16 channel analog multiplexer
-    class HC4067 : public AnalogMUX {
-    public:
-        HC4067(uint8_t* selPins, uint8_t sigPin, uint8_t enPin = 255)
-            : AnalogMUX(selPins, 4, sigPin, enPin) {}  // 4 select pins for 16 channels
         
-        MUXStatus setChannel(uint8_t channel) override {
-            if (!isValidChannel(channel)) return MUXStatus::ERROR_CHANNEL_INVALID;
-            if (!enabled) return MUXStatus::ERROR_NOT_ENABLED;
-            
-            // Disable before switching (break-before-make)
-            if (enablePin != 255) {
-                digitalWrite(enablePin, HIGH);
-                delayMicros(1);
+        // Repeated reads of the same channel skip the switch and the
+        // settling wait, until anything else switches or disables the mux
+        virtual uint16_t readChannel(uint8_t channel) {
+            MUXLIB_DIAG_SCOPE(readChannelHistogram);
+            if (!isSettled(channel)) {
+                if (setChannel(channel) != MUXStatus::OK) {
+                    return 0;
+                }
+                settle(settlingTime);
+                settledChannel = channel;
             }
             
-            for (uint8_t i = 0; i < 4; i++) {
-                digitalWrite(selectPins[i], (channel >> i) & 0x01);
+            uint16_t value = analogRead(signalPin);
+            MUXLIB_TRACE(trace(TraceOp::SAMPLE, channel, 0, value));
+            return value;
+        }
+        
+    protected:
+        // Select pin pattern of a physical input
+        uint8_t selectPattern(uint8_t physical) const {
+            if (chip.flags & CHIP_SWAP_A0_A1) {
+                return (physical & ~0x03) | ((physical & 0x02) >> 1) | ((physical & 0x01) << 1);
             }
-            
-            if (enablePin != 255) {
-                delayMicros(1);
-                digitalWrite(enablePin, LOW);
+            return physical;
+        }
+        
+        MUXStatus buildSelectTable() {
+            if (!selectTable) {
+                selectTable = (uint8_t*)malloc(maxChannels);
+                if (!selectTable) return MUXStatus::ERROR_INIT;
             }
-            
-            currentChannel = channel;
+            for (uint8_t ch = 0; ch < maxChannels; ch++) {
+                selectTable[ch] = selectPattern(channelMap ? channelMap[ch] : ch);
+            }
+            settledChannel = 255;
             return MUXStatus::OK;
         }
+        
+        // Drive the select lines for a logical channel, touching only the
+        // lines that change
+        void writeSelect(uint8_t channel) {
+            uint8_t pattern = selectTable ? selectTable[channel] : selectPattern(channel);
+            uint8_t changed = pattern ^ selectState;
+            #if defined(MUXLIB_GPIO_MULTI_WRITE)
+            // All lines in one call where the platform supports it
+            if (changed) digitalWriteMulti(selectPins, numSelectPins, pattern, changed);
+            #else
+            for (uint8_t i = 0; changed; i++, changed >>= 1) {
+                if (changed & 0x01) {
+                    digitalWrite(selectPins[i], (pattern >> i) & 0x01);
+                }
+            }
+            #endif
+            selectState = pattern;
+        }
+    };
+
+    // 74HC4051 - 8 channel analog multiplexer
+    class HC4051 : public AnalogMUX {
+    public:
+        HC4051(uint8_t* selPins, uint8_t sigPin, uint8_t enPin = 255)
+            : AnalogMUX(CHIP_HC4051, selPins, sigPin, enPin) {}
+    };
+
+    // 74HC4067 - 16 channel analog multiplexer
+    class HC4067 : public AnalogMUX {
+    public:
+        HC4067(uint8_t* selPins, uint8_t sigPin, uint8_t enPin = 255)
+            : AnalogMUX(CHIP_HC4067, selPins, sigPin, enPin) {}
     };
 
     // 74HC4052 - Dual 4-channel analog multiplexer
@@ -132,7 +385,7 @@ namespace MUXLib {
         
     public:
         HC4052(uint8_t* selPins, uint8_t sig1Pin, uint8_t sig2Pin, uint8_t enPin = 255)
-            : AnalogMUX(selPins, 2, sig1Pin, enPin), signalPin2(sig2Pin) {}  // 2 select pins for 4 channels each
+            : AnalogMUX(CHIP_HC4052, selPins, sig1Pin, enPin), signalPin2(sig2Pin) {}
         
         MUXStatus begin() override {
             MUXStatus status = AnalogMUX::begin();
@@ -145,41 +398,31 @@ namespace MUXLib {
             return MUXStatus::OK;
         }
         
-        MUXStatus setChannel(uint8_t channel) override {
-            if (channel >= 4) return MUXStatus::ERROR_CHANNEL_INVALID;
-            if (!enabled) return MUXStatus::ERROR_NOT_ENABLED;
-            
-            // Disable before switching
-            if (enablePin != 255) {
-                digitalWrite(enablePin, HIGH);
-                delayMicros(1);
-            }
-            
-            for (uint8_t i = 0; i < 2; i++) {
-                digitalWrite(selectPins[i], (channel >> i) & 0x01);
-            }
-            
-            if (enablePin != 255) {
-                delayMicros(1);
-                digitalWrite(enablePin, LOW);
-            }
-            
-            currentChannel = channel;
-            return MUXStatus::OK;
-        }
-        
         // Read from the second multiplexer
         uint16_t readChannel2(uint8_t channel) {
+            MUXLIB_DIAG_SCOPE(readChannelHistogram);
             if (setChannel(channel) != MUXStatus::OK) {
                 return 0;
             }
             
-            delayMicros(settlingTime);
+            settle(settlingTime);
             return analogRead(signalPin2);
         }
+        
+        // Read both sections at one address (values[0] = X, values[1] = Y)
+        MUXStatus readBoth(uint8_t channel, uint16_t* values) {
+            MUXStatus status = setChannel(channel);
+            if (status != MUXStatus::OK) return status;
+            
+            settle(settlingTime);
+            values[0] = analogRead(signalPin);
+            values[1] = (signalPin2 != 255) ? analogRead(signalPin2) : 0;
+            return MUXStatus::OK;
+        }
     };
 
-    // 74HC4053 - Triple 2-channel analog multiplexer
+    // 74HC4053 - Triple 2-channel analog multiplexer. setChannel() takes
+    // the three switch positions as bits 0-2.
     class HC4053 : public AnalogMUX {
     private:
         uint8_t signalPin2;
@@ -187,7 +430,7 @@ namespace MUXLib {
         
     public:
         HC4053(uint8_t* selPins, uint8_t sig1Pin, uint8_t sig2Pin, uint8_t sig3Pin, uint8_t enPin = 255)
-            : AnalogMUX(selPins, 3, sig1Pin, enPin), 
+            : AnalogMUX(CHIP_HC4053, selPins, sig1Pin, enPin), 
               signalPin2(sig2Pin), signalPin3(sig3Pin) {}  // 3 independent select pins
         
         MUXStatus begin() override {
@@ -202,203 +445,144 @@ namespace MUXLib {
         
         // Set individual switches (0 or 1 for each)
         MUXStatus setChannels(bool ch1, bool ch2, bool ch3) {
-            if (!enabled) return MUXStatus::ERROR_NOT_ENABLED;
-            
-            // Disable before switching
-            if (enablePin != 255) {
-                digitalWrite(enablePin, HIGH);
-                delayMicros(1);
-            }
-            
-            digitalWrite(selectPins[0], ch1);
-            digitalWrite(selectPins[1], ch2);
-            digitalWrite(selectPins[2], ch3);
-            
-            if (enablePin != 255) {
-                delayMicros(1);
-                digitalWrite(enablePin, LOW);
-            }
-            
-            return MUXStatus::OK;
+            return setChannel(ch1 | (ch2 << 1) | (ch3 << 2));
         }
         
         uint16_t readChannel2() {
-            delayMicros(settlingTime);
+            settle(settlingTime);
             return analogRead(signalPin2);
         }
         
         uint16_t readChannel3() {
-            delayMicros(settlingTime);
+            settle(settlingTime);
             return analogRead(signalPin3);
         }
+        
+        // Read all three switches after a single settling delay
+        void readAll(uint16_t* values) {
+            settle(settlingTime);
+            values[0] = analogRead(signalPin);
+            values[1] = (signalPin2 != 255) ? analogRead(signalPin2) : 0;
+            values[2] = (signalPin3 != 255) ? analogRead(signalPin3) : 0;
+        }
     };
 
-    // ADG508A/ADG509A - 8-channel analog multiplexer
-    class ADG508A : public AnalogMUX {
-    private:
-        bool isDifferential;  // ADG509A is differential version
-        uint8_t signalPinB;  // For differential mode (ADG509A)
+    // Shared differential acquisition for muxes switching a pair of lines
+    // (ADG509A, ADG707, ADG507A, DG409). Each measurement interleaves the
+    // legs A/B/A.../A around one settle, so a signal drifting linearly
+    // during the conversions cancels out instead of skewing the result.
+    // Where the platform has a differential or simultaneous dual ADC,
+    // install it with setDifferentialADC() and it is used instead.
+    class DifferentialMUX : public AnalogMUX {
+    public:
+        // Returns (A - B) for the currently selected pair
+        typedef int32_t (*DifferentialADC)(uint8_t pinA, uint8_t pinB);
+        
+    protected:
+        bool isDifferential;
+        uint8_t signalPinB;
+        uint8_t differentialPairs;  // B samples per measurement (A gets one more)
+        DifferentialADC differentialADC;
         
     public:
-        ADG508A(uint8_t* selPins, uint8_t sigPin, uint8_t enPin = 255, 
-                bool differential = false, uint8_t sigPinB = 255)
-            : AnalogMUX(selPins, 3, sigPin, enPin), 
-              isDifferential(differential), signalPinB(sigPinB) {}
+        DifferentialMUX(const ChipDescriptor& desc, uint8_t* selPins, uint8_t sigPin, uint8_t enPin,
+                        uint8_t strbPin, bool differential, uint8_t sigPinB)
+            : AnalogMUX(desc, selPins, sigPin, enPin, strbPin),
+              isDifferential(differential && sigPinB != 255), signalPinB(sigPinB),
+              differentialPairs(1), differentialADC(nullptr) {}
         
         MUXStatus begin() override {
             MUXStatus status = AnalogMUX::begin();
             if (status != MUXStatus::OK) return status;
             
-            if (isDifferential && signalPinB != 255) {
+            if (isDifferential) {
                 pinMode(signalPinB, INPUT);
             }
             
             return MUXStatus::OK;
         }
         
-        MUXStatus setChannel(uint8_t channel) override {
-            if (!isValidChannel(channel)) return MUXStatus::ERROR_CHANNEL_INVALID;
-            if (!enabled) return MUXStatus::ERROR_NOT_ENABLED;
-            
-            // Disable before switching
-            if (enablePin != 255) {
-                digitalWrite(enablePin, HIGH);
-                delayMicros(1);
-            }
-            
-            for (uint8_t i = 0; i < 3; i++) {
-                digitalWrite(selectPins[i], (channel >> i) & 0x01);
-            }
-            
-            if (enablePin != 255) {
-                delayMicros(1);
-                digitalWrite(enablePin, LOW);
-            }
-            
-            currentChannel = channel;
-            return MUXStatus::OK;
+        // Number of B conversions per measurement: 1 gives A/B/A, 2 gives
+        // A/B/A/B/A, ... More pairs average noise at the cost of time.
+        void setDifferentialSamples(uint8_t pairs) {
+            differentialPairs = pairs ? pairs : 1;
         }
         
-        // For differential mode (ADG509A)
-        int16_t readDifferential(uint8_t channel) {
-            if (!isDifferential || signalPinB == 255) return 0;
-            
-            setChannel(channel);
-            delayMicros(settlingTime);
-            return analogRead(signalPin) - analogRead(signalPinB);
+        void setDifferentialADC(DifferentialADC adc) {
+            differentialADC = adc;
         }
-    };
-
-    // ADG706/ADG707 16:1 Multiplexer
-    class ADG706 : public AnalogMUX {
-    private:
-        uint8_t writePin;
-        bool isDifferential;  // ADG707 is differential version
-        uint8_t signalPinB;
         
-    public:
-        ADG706(uint8_t* addrPins, uint8_t sigPin, uint8_t wrPin, 
-               uint8_t enPin = 255, bool differential = false, uint8_t sigPinB = 255)
-            : AnalogMUX(addrPins, 4, sigPin, enPin),
-              writePin(wrPin), isDifferential(differential), signalPinB(sigPinB) {}
-        
-        MUXStatus begin() override {
-            MUXStatus status = AnalogMUX::begin();
-            if (status != MUXStatus::OK) return status;
+        // Measure the pair that is selected now, without switching or settling
+        int32_t sampleDifferential() {
+            if (!isDifferential) return 0;
+            if (differentialADC) return differentialADC(signalPin, signalPinB);
             
-            pinMode(writePin, OUTPUT);
-            digitalWrite(writePin, HIGH);
-            
-            if (isDifferential && signalPinB != 255) {
-                pinMode(signalPinB, INPUT);
+            int32_t sumA = analogRead(signalPin);
+            int32_t sumB = 0;
+            for (uint8_t i = 0; i < differentialPairs; i++) {
+                sumB += analogRead(signalPinB);
+                sumA += analogRead(signalPin);
             }
             
-            return MUXStatus::OK;
+            // mean(A) - mean(B) over n + 1 A and n B conversions, rounded
+            int32_t n = differentialPairs;
+            int32_t scaled = sumA * n - sumB * (n + 1);
+            int32_t divisor = n * (n + 1);
+            return (scaled >= 0) ? (scaled + divisor / 2) / divisor : (scaled - divisor / 2) / divisor;
         }
         
-        MUXStatus setChannel(uint8_t channel) override {
-            if (!isValidChannel(channel)) return MUXStatus::ERROR_CHANNEL_INVALID;
-            if (!enabled) return MUXStatus::ERROR_NOT_ENABLED;
-            
-            // Set address before write pulse
-            for (uint8_t i = 0; i < 4; i++) {
-                digitalWrite(selectPins[i], (channel >> i) & 0x01);
-            }
+        int32_t readDifferential(uint8_t channel) {
+            if (!isDifferential) return 0;
+            if (setChannel(channel) != MUXStatus::OK) return 0;
             
-            // Generate write pulse
-            digitalWrite(writePin, LOW);
-            delayMicros(1);
-            digitalWrite(writePin, HIGH);
-            
-            currentChannel = channel;
-            return MUXStatus::OK;
+            settle(settlingTime);
+            return sampleDifferential();
         }
         
-        int16_t readDifferential(uint8_t channel) {
-            if (!isDifferential || signalPinB == 255) return 0;
+        // Sweep 'count' pairs from 'first', one switch and one settle per
+        // pair. At most 'capacity' results are written. Returns the number
+        // of pairs measured.
+        uint8_t readDifferentialAll(int32_t* results, uint8_t capacity, uint8_t first = 0, uint8_t count = 255) {
+            if (!isDifferential || !results) return 0;
+            if (count > capacity) count = capacity;
             
-            setChannel(channel);
-            delayMicros(settlingTime);
-            return analogRead(signalPin) - analogRead(signalPinB);
+            uint8_t measured = 0;
+            for (uint16_t ch = first; ch < maxChannels && measured < count; ch++) {
+                if (setChannel(ch) != MUXStatus::OK) break;
+                settle(settlingTime);
+                results[measured++] = sampleDifferential();
+            }
+            return measured;
         }
+        
+        bool isDifferentialMode() const { return isDifferential; }
+    };
+
+    // ADG508A/ADG509A - 8-channel analog multiplexer
+    // ADG509A is the differential version
+    class ADG508A : public DifferentialMUX {
+    public:
+        ADG508A(uint8_t* selPins, uint8_t sigPin, uint8_t enPin = 255, 
+                bool differential = false, uint8_t sigPinB = 255)
+            : DifferentialMUX(CHIP_ADG508A, selPins, sigPin, enPin, 255, differential, sigPinB) {}
+    };
+
+    // ADG706/ADG707 16:1 Multiplexer, address latched by the WR pulse
+    // ADG707 is the differential version
+    class ADG706 : public DifferentialMUX {
+    public:
+        ADG706(uint8_t* addrPins, uint8_t sigPin, uint8_t wrPin, 
+               uint8_t enPin = 255, bool differential = false, uint8_t sigPinB = 255)
+            : DifferentialMUX(CHIP_ADG706, addrPins, sigPin, enPin, wrPin, differential, sigPinB) {}
     };
 
     // ADG506A/ADG507A - 16/8 channel multiplexer with differential capability
-    class ADG506A : public AnalogMUX {
-    private:
-        bool isDifferential;
-        uint8_t signalPinB;
-        bool is506;  // true for ADG506A, false for ADG507A
-        
+    class ADG506A : public DifferentialMUX {
     public:
         ADG506A(uint8_t* addrPins, uint8_t sigPin, bool is506A = true,
                 uint8_t enPin = 255, bool differential = false, uint8_t sigPinB = 255)
-            : AnalogMUX(addrPins, is506A ? 4 : 3, sigPin, enPin),
-              isDifferential(differential), signalPinB(sigPinB), is506(is506A) {}
-        
-        MUXStatus begin() override {
-            MUXStatus status = AnalogMUX::begin();
-            if (status != MUXStatus::OK) return status;
-            
-            if (isDifferential && signalPinB != 255) {
-                pinMode(signalPinB, INPUT);
-            }
-            
-            return MUXStatus::OK;
-        }
-        
-        MUXStatus setChannel(uint8_t channel) override {
-            uint8_t maxChannel = is506 ? 16 : 8;
-            if (channel >= maxChannel) return MUXStatus::ERROR_CHANNEL_INVALID;
-            if (!enabled) return MUXStatus::ERROR_NOT_ENABLED;
-            
-            // Disable before switching
-            if (enablePin != 255) {
-                digitalWrite(enablePin, HIGH);
-                delayMicros(1);
-            }
-            
-            for (uint8_t i = 0; i < numSelectPins; i++) {
-                digitalWrite(selectPins[i], (channel >> i) & 0x01);
-            }
-            
-            if (enablePin != 255) {
-                delayMicros(1);
-                digitalWrite(enablePin, LOW);
-            }
-            
-            currentChannel = channel;
-            returncurrentChannel = channel;
-            return MUXStatus::OK;
-        }
-        
-        int16_t readDifferential(uint8_t channel) {
-            if (!isDifferential || signalPinB == 255) return 0;
-            
-            setChannel(channel);
-            delayMicros(settlingTime);
-            return analogRead(signalPin) - analogRead(signalPinB);
-        }
+            : DifferentialMUX(is506A ? CHIP_ADG506A : CHIP_ADG507A, addrPins, sigPin, enPin, 255,
+                              differential, sigPinB) {}
     };
 
     // MPC506A/MPC507A - Pin compatible with ADG506A/ADG507A
@@ -414,120 +598,240 @@ namespace MUXLib {
     };
 
     // DG408/DG409 - 8-channel differential multiplexer
-    class DG408 : public AnalogMUX {
-    private:
-        uint8_t signalPinB;
-        bool isDG409;  // DG409 has different channel addressing
-        
+    class DG408 : public DifferentialMUX {
     public:
         DG408(uint8_t* selPins, uint8_t sigPin, uint8_t sigPinB, 
               uint8_t enPin = 255, bool isDG409Mode = false)
-            : AnalogMUX(selPins, 3, sigPin, enPin),
-              signalPinB(sigPinB), isDG409(isDG409Mode) {
-            setSettlingTime(150);  // Default settling time for DG408/409
+            : DifferentialMUX(isDG409Mode ? CHIP_DG409 : CHIP_DG408, selPins, sigPin, enPin, 255,
+                              true, sigPinB) {}
+    };
+
+    // MAX4051A - 8-channel analog multiplexer with low resistance
+    class MAX4051A : public AnalogMUX {
+    public:
+        MAX4051A(uint8_t* selPins, uint8_t sigPin, uint8_t enPin = 255)
+            : AnalogMUX(CHIP_MAX4051A, selPins, sigPin, enPin) {}
+    };
+
+    // MAX4582 - Precision 8:1 analog multiplexer, address taken on the load pulse
+    class MAX4582 : public AnalogMUX {
+    public:
+        MAX4582(uint8_t* selPins, uint8_t sigPin, uint8_t ldPin, uint8_t enPin = 255)
+            : AnalogMUX(CHIP_MAX4582, selPins, sigPin, enPin, ldPin) {}
+    };
+
+    // Bank of identical multiplexers sharing one select bus
+    // (e.g. 4x HC4067 on common S0-S3 with separate SIG pins).
+    // The address is set once and every bank is read before moving on.
+    // The bank enables and a shared strobe follow the chip descriptor,
+    // as in the single-chip engine.
+    class MUXBank : public AnalogMUX {
+    protected:
+        uint8_t* bankSignalPins;
+        uint8_t* bankEnablePins;    // Optional, one per bank
+        uint8_t numBanks;
+        bool sharedSignal;          // All banks wired to the same SIG pin
+        bool addressValid;
+        
+        void driveBankEnable(uint8_t pin, bool on) {
+            if (pin != 255) {
+                digitalWrite(pin, on == ((chip.flags & CHIP_ENABLE_HIGH) != 0));
+            }
+        }
+        
+        void setBankEnables(bool on) {
+            if (!bankEnablePins) return;
+            settledChannel = 255;
+            for (uint8_t b = 0; b < numBanks; b++) {
+                driveBankEnable(bankEnablePins[b], on);
+            }
+        }
+        
+        // Enable only one bank (used when the banks share a signal pin)
+        void selectBank(uint8_t bank) {
+            settledChannel = 255;
+            for (uint8_t b = 0; b < numBanks; b++) {
+                driveBankEnable(bankEnablePins[b], b == bank);
+            }
+        }
+        
+    public:
+        MUXBank(const ChipDescriptor& desc, uint8_t* selPins, uint8_t* sigPins, uint8_t banks,
+                uint8_t* enPins = nullptr, uint8_t strbPin = 255)
+            : AnalogMUX(desc, selPins, sigPins[0], 255, strbPin), bankEnablePins(nullptr),
+              numBanks(banks), sharedSignal(false), addressValid(false) {
+            bankSignalPins = (uint8_t*)malloc(banks * sizeof(uint8_t));
+            if (bankSignalPins) {
+                memcpy(bankSignalPins, sigPins, banks * sizeof(uint8_t));
+            }
+            if (enPins) {
+                bankEnablePins = (uint8_t*)malloc(banks * sizeof(uint8_t));
+                if (bankEnablePins) {
+                    memcpy(bankEnablePins, enPins, banks * sizeof(uint8_t));
+                }
+            }
+        }
+        
+        // Plain binary-addressed parts with active LOW enables
+        MUXBank(uint8_t* selPins, uint8_t numPins, uint8_t* sigPins, uint8_t banks,
+                uint8_t* enPins = nullptr)
+            : MUXBank(ChipDescriptor{numPins, CHIP_BREAK_BEFORE_MAKE, 1, 10}, selPins, sigPins, banks, enPins) {}
+        
+        ~MUXBank() {
+            if (bankSignalPins) free(bankSignalPins);
+            if (bankEnablePins) free(bankEnablePins);
         }
         
         MUXStatus begin() override {
+            if (!bankSignalPins || numBanks == 0) return MUXStatus::ERROR_INIT;
+            
             MUXStatus status = AnalogMUX::begin();
             if (status != MUXStatus::OK) return status;
             
-            pinMode(signalPinB, INPUT);
+            sharedSignal = (numBanks > 1);
+            for (uint8_t b = 0; b < numBanks; b++) {
+                pinMode(bankSignalPins[b], INPUT);
+                if (bankSignalPins[b] != bankSignalPins[0]) sharedSignal = false;
+                if (bankEnablePins && bankEnablePins[b] != 255) {
+                    pinMode(bankEnablePins[b], OUTPUT);
+                    driveBankEnable(bankEnablePins[b], false);
+                }
+            }
+            
+            // A shared signal pin needs per-bank enables to tell the banks apart
+            if (sharedSignal && !bankEnablePins) return MUXStatus::ERROR_INIT;
+            
+            addressValid = false;
             return MUXStatus::OK;
         }
         
         MUXStatus setChannel(uint8_t channel) override {
-            if (channel >= 8) return MUXStatus::ERROR_CHANNEL_INVALID;
+            if (!isValidChannel(channel)) return MUXStatus::ERROR_CHANNEL_INVALID;
             if (!enabled) return MUXStatus::ERROR_NOT_ENABLED;
+            MUXLIB_DIAG_SCOPE(setChannelHistogram);
+            MUXLIB_TRACE_SCOPE(channel);
+            MUXLIB_DIAG(diagSwitch(channel));
+            
+            settledChannel = 255;
             
-            // DG409 has different channel addressing pattern
-            if (isDG409) {
-                channel = (channel & 0x04) | ((channel & 0x02) >> 1) | 
-                         ((channel & 0x01) << 1);
+            // Break-before-make across every bank
+            bool breakFirst = (chip.flags & CHIP_BREAK_BEFORE_MAKE) && bankEnablePins;
+            if (breakFirst) {
+                setBankEnables(false);
+                delayMicros(chip.pulseMicros);
             }
             
-            for (uint8_t i = 0; i < 3; i++) {
-                digitalWrite(selectPins[i], (channel >> i) & 0x01);
+            writeSelect(channel);
+            
+            if (chip.flags & CHIP_STROBE) {
+                digitalWrite(strobePin, LOW);
+                delayMicros(chip.pulseMicros);
+                digitalWrite(strobePin, HIGH);
+            }
+            
+            // Banks sharing a SIG pin are enabled one at a time when read
+            if (!sharedSignal) {
+                if (breakFirst) delayMicros(chip.pulseMicros);
+                setBankEnables(true);
             }
             
             currentChannel = channel;
+            addressValid = true;
             return MUXStatus::OK;
         }
         
-        int16_t readDifferential(uint8_t channel) {
-            setChannel(channel);
-            delayMicros(settlingTime);
-            return analogRead(signalPin) - analogRead(signalPinB);
-        }
-    };
-
-    // MAX4051A - 8-channel analog multiplexer with low resistance
-    class MAX4051A : public AnalogMUX {
-    public:
-        MAX4051A(uint8_t* selPins, uint8_t sigPin, uint8_t enPin = 255)
-            : AnalogMUX(selPins, 3, sigPin, enPin) {
-            setSettlingTime(5);  // Faster settling time than HC4051
-        }
-        
-        MUXStatus setChannel(uint8_t channel) override {
-            if (!isValidChannel(channel)) return MUXStatus::ERROR_CHANNEL_INVALID;
+        // Read every bank at one address; values must hold getBankCount() entries
+        MUXStatus readAll(uint8_t channel, uint16_t* values) {
+            MUXLIB_DIAG_SCOPE(readChannelHistogram);
             if (!enabled) return MUXStatus::ERROR_NOT_ENABLED;
+            if (!addressValid || channel != currentChannel) {
+                MUXStatus status = setChannel(channel);
+                if (status != MUXStatus::OK) return status;
+            }
             
-            if (enablePin != 255) {
-                digitalWrite(enablePin, HIGH);
-                delayMicros(1);
+            if (!sharedSignal) settle(settlingTime);
+            for (uint8_t b = 0; b < numBanks; b++) {
+                if (sharedSignal) {
+                    selectBank(b);
+                    settle(settlingTime);
+                }
+                values[b] = analogRead(bankSignalPins[b]);
             }
+            if (sharedSignal) setBankEnables(false);
             
-            for (uint8_t i = 0; i < 3; i++) {
-                digitalWrite(selectPins[i], (channel >> i) & 0x01);
+            return MUXStatus::OK;
+        }
+        
+        // Digital variant of readAll, bit b of the result is bank b (up to 32 banks)
+        uint32_t readAllDigital(uint8_t channel) {
+            if (!enabled) return 0;
+            if (!addressValid || channel != currentChannel) {
+                if (setChannel(channel) != MUXStatus::OK) return 0;
             }
             
-            if (enablePin != 255) {
-                delayMicros(1);
-                digitalWrite(enablePin, LOW);
+            if (!sharedSignal) settle(settlingTime);
+            uint32_t bits = 0;
+            for (uint8_t b = 0; b < numBanks && b < 32; b++) {
+                if (sharedSignal) {
+                    selectBank(b);
+                    settle(settlingTime);
+                }
+                if (digitalRead(bankSignalPins[b])) {
+                    bits |= (1UL << b);
+                }
             }
+            if (sharedSignal) setBankEnables(false);
             
-            currentChannel = channel;
-            return MUXStatus::OK;
+            return bits;
         }
-    };
-
-    // MAX4582 - Precision 8:1 analog multiplexer
-    class MAX4582 : public AnalogMUX {
-    private:
-        uint8_t loadPin;  // Load pin for synchronous operation
         
-    public:
-        MAX4582(uint8_t* selPins, uint8_t sigPin, uint8_t ldPin, uint8_t enPin = 255)
-            : AnalogMUX(selPins, 3, sigPin, enPin), loadPin(ldPin) {
-            setSettlingTime(15);
+        // Read a single bank/channel pair
+        uint16_t readBank(uint8_t bank, uint8_t channel) {
+            if (bank >= numBanks || !enabled) return 0;
+            if (!addressValid || channel != currentChannel) {
+                if (setChannel(channel) != MUXStatus::OK) return 0;
+            }
+            
+            if (sharedSignal) selectBank(bank);
+            settle(settlingTime);
+            uint16_t value = analogRead(bankSignalPins[bank]);
+            if (sharedSignal) setBankEnables(false);
+            return value;
         }
         
-        MUXStatus begin() override {
-            MUXStatus status = AnalogMUX::begin();
-            if (status != MUXStatus::OK) return status;
+        // Sweep every address once. values[bank * channelsPerBank + channel]
+        // must hold getTotalChannels() entries.
+        MUXStatus scan(uint16_t* values) {
+            uint16_t atAddress[32];
+            if (numBanks > 32) return MUXStatus::ERROR_OVERFLOW;
             
-            pinMode(loadPin, OUTPUT);
-            digitalWrite(loadPin, HIGH);
+            for (uint8_t ch = 0; ch < maxChannels; ch++) {
+                MUXStatus status = readAll(ch, atAddress);
+                if (status != MUXStatus::OK) return status;
+                for (uint8_t b = 0; b < numBanks; b++) {
+                    values[(uint16_t)b * maxChannels + ch] = atAddress[b];
+                }
+            }
             return MUXStatus::OK;
         }
         
-        MUXStatus setChannel(uint8_t channel) override {
-            if (!isValidChannel(channel)) return MUXStatus::ERROR_CHANNEL_INVALID;
-            if (!enabled) return MUXStatus::ERROR_NOT_ENABLED;
-            
-            // Set up address bits while load is high
-            for (uint8_t i = 0; i < 3; i++) {
-                digitalWrite(selectPins[i], (channel >> i) & 0x01);
-            }
-            
-            // Generate load pulse
-            digitalWrite(loadPin, LOW);
-            delayMicros(1);
-            digitalWrite(loadPin, HIGH);
+        // Also switch every bank off; the next read re-selects the address
+        void disable() override {
+            setBankEnables(false);
+            addressValid = false;
+            AnalogMUX::disable();
+        }
+        
+        void sleep() override {
+            if (sleeping || !enabled) return;
             
-            currentChannel = channel;
-            return MUXStatus::OK;
+            setBankEnables(false);
+            addressValid = false;
+            AnalogMUX::sleep();
         }
+        
+        uint8_t getBankCount() const { return numBanks; }
+        uint16_t getTotalChannels() const { return (uint16_t)numBanks * maxChannels; }
     };
 }
 
@@ -0,0 +1,200 @@
+// Change-Driven Acquisition Filter (ChangeFilter.h)
+#ifndef CHANGEFILTER_H
+#define CHANGEFILTER_H
+
+#include "MUXLib.h"
+#include "AnalogMUX.h"
+
+namespace MUXLib {
+    // Called for every channel whose value moved beyond its deadband
+    typedef void (*ChangeCallback)(uint8_t channel, uint16_t value);
+
+    // Per-channel deadband filter layered on top of scan output.
+    // Keeps the last reported value of each channel and only reports
+    // channels that moved, with optional hysteresis on direction
+    // reversals and a minimum interval between reports.
+    class ChangeFilter {
+    private:
+        struct ChannelState {
+            uint16_t lastValue;     // Last reported value
+            uint16_t deadband;      // Change must exceed this to be reported
+            uint16_t hysteresis;    // Extra margin when the direction reverses
+            uint16_t lastReport;    // millis() of last report (low 16 bits)
+            int8_t direction;       // -1, 0, +1 of the last reported move
+            bool reported;          // False until the first report
+        };
+        
+        ChannelState* channels;
+        uint8_t* dirtyBits;
+        uint8_t numChannels;
+        uint16_t minInterval;       // milliseconds, 0 = no rate limit
+        
+    public:
+        ChangeFilter(uint8_t channelCount, uint16_t deadband = 0)
+            : numChannels(channelCount), minInterval(0) {
+            channels = (ChannelState*)malloc(channelCount * sizeof(ChannelState));
+            dirtyBits = (uint8_t*)malloc((channelCount + 7) / 8);
+            if (channels) {
+                for (uint8_t i = 0; i < channelCount; i++) {
+                    channels[i].deadband = deadband;
+                    channels[i].hysteresis = 0;
+                }
+            }
+            reset();
+        }
+        
+        ~ChangeFilter() {
+            if (channels) free(channels);
+            if (dirtyBits) free(dirtyBits);
+        }
+        
+        MUXStatus begin() {
+            if (!channels || !dirtyBits) return MUXStatus::ERROR_INIT;
+            reset();
+            return MUXStatus::OK;
+        }
+        
+        // Forget all reported values; the next sample of each channel is reported
+        void reset() {
+            if (channels) {
+                for (uint8_t i = 0; i < numChannels; i++) {
+                    channels[i].lastValue = 0;
+                    channels[i].lastReport = 0;
+                    channels[i].direction = 0;
+                    channels[i].reported = false;
+                }
+            }
+            clearDirty();
+        }
+        
+        void setDeadband(uint16_t deadband) {
+            if (!channels) return;
+            for (uint8_t i = 0; i < numChannels; i++) {
+                channels[i].deadband = deadband;
+            }
+        }
+        
+        void setDeadband(uint8_t channel, uint16_t deadband) {
+            if (channels && channel < numChannels) {
+                channels[channel].deadband = deadband;
+            }
+        }
+        
+        void setHysteresis(uint16_t hysteresis) {
+            if (!channels) return;
+            for (uint8_t i = 0; i < numChannels; i++) {
+                channels[i].hysteresis = hysteresis;
+            }
+        }
+        
+        void setHysteresis(uint8_t channel, uint16_t hysteresis) {
+            if (channels && channel < numChannels) {
+                channels[channel].hysteresis = hysteresis;
+            }
+        }
+        
+        // Minimum time between two reports of the same channel
+        void setMinInterval(uint16_t milliseconds) {
+            minInterval = milliseconds;
+        }
+        
+        // Feed one sample. Returns true (and marks the channel dirty) if it is reported.
+        bool update(uint8_t channel, uint16_t value) {
+            if (!channels || channel >= numChannels) return false;
+            ChannelState& state = channels[channel];
+            uint16_t now = (uint16_t)millis();
+            
+            if (state.reported) {
+                int32_t delta = (int32_t)value - state.lastValue;
+                int8_t direction = (delta > 0) ? 1 : ((delta < 0) ? -1 : 0);
+                uint32_t magnitude = (delta < 0) ? -delta : delta;
+                
+                uint32_t threshold = state.deadband;
+                if (direction != 0 && state.direction != 0 && direction != state.direction) {
+                    threshold += state.hysteresis;
+                }
+                
+                if (magnitude <= threshold) return false;
+                if (minInterval && (uint16_t)(now - state.lastReport) < minInterval) return false;
+                
+                state.direction = direction;
+            }
+            
+            state.lastValue = value;
+            state.lastReport = now;
+            state.reported = true;
+            dirtyBits[channel >> 3] |= (1 << (channel & 0x07));
+            return true;
+        }
+        
+        // Read channels [0, channelCount) of an analog mux through the filter.
+        // Returns the number of channels reported.
+        uint8_t scan(AnalogMUX& mux, ChangeCallback callback = nullptr) {
+            uint8_t changed = 0;
+            for (uint8_t ch = 0; ch < numChannels; ch++) {
+                uint16_t value = mux.readChannel(ch);
+                if (update(ch, value)) {
+                    changed++;
+                    if (callback) callback(ch, value);
+                }
+            }
+            return changed;
+        }
+        
+        uint16_t getValue(uint8_t channel) const {
+            if (!channels || channel >= numChannels) return 0;
+            return channels[channel].lastValue;
+        }
+        
+        // Dirty channel bitmap: set on report, cleared by the application
+        bool isDirty(uint8_t channel) const {
+            if (!dirtyBits || channel >= numChannels) return false;
+            return dirtyBits[channel >> 3] & (1 << (channel & 0x07));
+        }
+        
+        void clearDirty(uint8_t channel) {
+            if (dirtyBits && channel < numChannels) {
+                dirtyBits[channel >> 3] &= ~(1 << (channel & 0x07));
+            }
+        }
+        
+        void clearDirty() {
+            if (dirtyBits) memset(dirtyBits, 0, (numChannels + 7) / 8);
+        }
+        
+        bool anyDirty() const {
+            if (!dirtyBits) return false;
+            for (uint8_t i = 0; i < (numChannels + 7) / 8; i++) {
+                if (dirtyBits[i]) return true;
+            }
+            return false;
+        }
+        
+        // Dirty flags of channels 0-31 as a single word
+        uint32_t getDirtyMask() const {
+            uint32_t mask = 0;
+            if (!dirtyBits) return 0;
+            for (uint8_t i = 0; i < (numChannels + 7) / 8 && i < 4; i++) {
+                mask |= (uint32_t)dirtyBits[i] << (i * 8);
+            }
+            return mask;
+        }
+        
+        const uint8_t* getDirtyBitmap() const { return dirtyBits; }
+        
+        // Next dirty channel at or after 'from', or 255 if none
+        uint8_t nextDirty(uint8_t from = 0) const {
+            if (!dirtyBits) return 255;
+            for (uint16_t ch = from; ch < numChannels; ch++) {
+                if (!(dirtyBits[ch >> 3])) {
+                    ch |= 0x07;  // Skip the rest of an empty byte
+                    continue;
+                }
+                if (isDirty(ch)) return ch;
+            }
+            return 255;
+        }
+    };
+}
+
+#endif
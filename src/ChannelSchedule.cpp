@@ -0,0 +1,37 @@
+// Channel Schedule Timer Backend (ChannelSchedule.cpp)
+#include "ChannelSchedule.h"
+
+#if defined(ESP32)
+namespace MUXLib {
+    ChannelSchedule* volatile ChannelSchedule::active = nullptr;
+    hw_timer_t* ChannelSchedule::timer = nullptr;
+
+    // The timer counts microseconds and free-runs; alarms are one-shot
+    // and re-armed by service() relative to the current count
+    void ChannelSchedule::startTimer() {
+        if (!timer) {
+            #if defined(ESP_ARDUINO_VERSION_MAJOR) && ESP_ARDUINO_VERSION_MAJOR >= 3
+            timer = timerBegin(1000000);
+            timerAttachInterrupt(timer, &ChannelSchedule::timerISR);
+            #else
+            timer = timerBegin(MUXLIB_SCHEDULE_TIMER, 80, true);
+            timerAttachInterrupt(timer, &ChannelSchedule::timerISR, true);
+            #endif
+        }
+        timerStart(timer);
+    }
+
+    void MUXLIB_ISR_ATTR ChannelSchedule::armTimer(uint32_t leadMicros) {
+        #if defined(ESP_ARDUINO_VERSION_MAJOR) && ESP_ARDUINO_VERSION_MAJOR >= 3
+        timerAlarm(timer, timerRead(timer) + leadMicros, false, 0);
+        #else
+        timerAlarmWrite(timer, timerRead(timer) + leadMicros, false);
+        timerAlarmEnable(timer);
+        #endif
+    }
+
+    void MUXLIB_ISR_ATTR ChannelSchedule::stopTimer() {
+        if (timer) timerStop(timer);
+    }
+}
+#endif
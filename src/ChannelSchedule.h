@@ -0,0 +1,263 @@
+// Timer-Driven Channel Schedules (ChannelSchedule.h)
+#ifndef CHANNELSCHEDULE_H
+#define CHANNELSCHEDULE_H
+
+#include "MUXLib.h"
+#include "SpecializedMUX.h"
+
+// Deadlines closer than this (microseconds) are met by spinning in the ISR
+// instead of re-arming the timer
+#ifndef MUXLIB_SCHEDULE_MIN_LEAD
+    #define MUXLIB_SCHEDULE_MIN_LEAD 10
+#endif
+
+// ESP32 hardware timer used for playback
+#ifndef MUXLIB_SCHEDULE_TIMER
+    #define MUXLIB_SCHEDULE_TIMER 0
+#endif
+
+// AVR playback uses Timer1, which Servo and others also claim, so it is
+// opt-in: define MUXLIB_SCHEDULE_USE_TIMER1 before including this header,
+// in one source file only (the header then defines the compare ISR)
+#if defined(ESP32) || (defined(__AVR__) && defined(MUXLIB_SCHEDULE_USE_TIMER1))
+    #define MUXLIB_SCHEDULE_HW_TIMER 1
+#else
+    #define MUXLIB_SCHEDULE_HW_TIMER 0
+#endif
+
+namespace MUXLib {
+    struct ScheduleStep {
+        uint32_t setMask;       // GPIO bits driven high (0 = per-pin writes)
+        uint32_t clearMask;     // GPIO bits driven low
+        uint32_t dwellMicros;   // Time until the next step
+        uint8_t channel;
+    };
+
+    // Playlist of (channel, dwell) steps for a FastMUX. compile() turns
+    // each step into the GPIO words that select it, and start() plays the
+    // steps back from a hardware timer, so the ISR only writes precomputed
+    // registers at absolute deadlines and call overhead never accumulates.
+    // Without a hardware timer, call tick() as often as possible instead.
+    // Only one schedule can own the hardware timer at a time.
+    class ChannelSchedule {
+    private:
+        ScheduleStep* steps;
+        uint16_t capacity;
+        uint16_t length;
+        FastMUX* mux;
+        bool compiled;
+        bool looping;
+        volatile bool running;
+        volatile uint16_t position;
+        volatile uint32_t loopCount;
+        uint32_t deadline;      // Due time of steps[position]
+        uint32_t loopMicros;    // Total dwell of one pass, from compile()
+        
+        static ChannelSchedule* volatile active;
+        
+        #if defined(ESP32)
+        static hw_timer_t* timer;
+        #endif
+        
+        static uint32_t MUXLIB_ISR_ATTR now() {
+            #if defined(ESP32)
+            return (uint32_t)timerRead(timer);
+            #else
+            return micros();
+            #endif
+        }
+        
+        static void startTimer();
+        static void armTimer(uint32_t leadMicros);
+        static void stopTimer();
+        
+        // Apply the due step and move to the next; false once a one-shot
+        // schedule has played its last step
+        bool MUXLIB_ISR_ATTR step() {
+            const ScheduleStep& s = steps[position];
+            mux->writeMasks(s.channel, s.setMask, s.clearMask);
+            deadline += s.dwellMicros;
+            
+            uint16_t next = position + 1;
+            if (next >= length) {
+                next = 0;
+                loopCount++;
+                if (!looping) {
+                    running = false;
+                    return false;
+                }
+            }
+            position = next;
+            return true;
+        }
+        
+        // Timer context: play every step that is due, then re-arm
+        void MUXLIB_ISR_ATTR service() {
+            while (running) {
+                int32_t lead = (int32_t)(deadline - now());
+                if (lead > MUXLIB_SCHEDULE_MIN_LEAD) {
+                    armTimer(lead);
+                    return;
+                }
+                while (lead > 0) {
+                    lead = (int32_t)(deadline - now());
+                }
+                step();
+            }
+            stopTimer();
+            active = nullptr;
+        }
+        
+    public:
+        ChannelSchedule(uint16_t maxSteps)
+            : capacity(maxSteps), length(0), mux(nullptr), compiled(false),
+              looping(true), running(false), position(0), loopCount(0), deadline(0), loopMicros(0) {
+            steps = (ScheduleStep*)malloc(maxSteps * sizeof(ScheduleStep));
+        }
+        
+        ~ChannelSchedule() {
+            stop();
+            if (steps) free(steps);
+        }
+        
+        // Append a step; the schedule must be compiled again before playback
+        MUXStatus add(uint8_t channel, uint32_t dwellMicros) {
+            if (!steps) return MUXStatus::ERROR_INIT;
+            if (running) return MUXStatus::ERROR_NOT_ENABLED;
+            if (length >= capacity) return MUXStatus::ERROR_OVERFLOW;
+            
+            steps[length].channel = channel;
+            steps[length].dwellMicros = dwellMicros;
+            steps[length].setMask = 0;
+            steps[length].clearMask = 0;
+            length++;
+            compiled = false;
+            return MUXStatus::OK;
+        }
+        
+        void clear() {
+            stop();
+            length = 0;
+            compiled = false;
+        }
+        
+        // Resolve every step to the pin states of this mux
+        MUXStatus compile(FastMUX& target) {
+            if (!steps) return MUXStatus::ERROR_INIT;
+            if (running) return MUXStatus::ERROR_NOT_ENABLED;
+            
+            loopMicros = 0;
+            for (uint16_t i = 0; i < length; i++) {
+                if (steps[i].channel >= target.getMaxChannels()) {
+                    return MUXStatus::ERROR_CHANNEL_INVALID;
+                }
+                target.channelMasks(steps[i].channel, steps[i].setMask, steps[i].clearMask);
+                uint32_t dwell = steps[i].dwellMicros;
+                loopMicros = (loopMicros + dwell < loopMicros) ? 0xFFFFFFFFUL : loopMicros + dwell;
+            }
+            
+            mux = &target;
+            compiled = true;
+            return MUXStatus::OK;
+        }
+        
+        // Play from the first step, once or looping. The first step is applied immediately.
+        // A loop must take longer than MUXLIB_SCHEDULE_MIN_LEAD, or playback
+        // would never get ahead of the clock and the timer would never return.
+        MUXStatus start(bool loop = true) {
+            if (!compiled || !length) return MUXStatus::ERROR_INIT;
+            if (loop && loopMicros <= MUXLIB_SCHEDULE_MIN_LEAD) return MUXStatus::ERROR_INIT;
+            if (!mux->isEnabled()) return MUXStatus::ERROR_NOT_ENABLED;
+            
+            stop();
+            #if MUXLIB_SCHEDULE_HW_TIMER
+            if (active) return MUXStatus::ERROR_OVERFLOW;
+            #endif
+            looping = loop;
+            position = 0;
+            loopCount = 0;
+            running = true;
+            
+            #if MUXLIB_SCHEDULE_HW_TIMER
+            active = this;
+            startTimer();
+            deadline = now();
+            service();
+            #else
+            deadline = now();
+            tick();
+            #endif
+            return MUXStatus::OK;
+        }
+        
+        void stop() {
+            #if MUXLIB_SCHEDULE_HW_TIMER
+            noInterrupts();
+            if (active == this) {
+                stopTimer();
+                active = nullptr;
+            }
+            running = false;
+            interrupts();
+            #else
+            running = false;
+            #endif
+        }
+        
+        // Polled playback where no hardware timer is available; a no-op otherwise
+        void tick() {
+            #if !MUXLIB_SCHEDULE_HW_TIMER
+            while (running && (int32_t)(now() - deadline) >= 0) {
+                step();
+            }
+            #endif
+        }
+        
+        // Timer interrupt entry point
+        static void MUXLIB_ISR_ATTR timerISR() {
+            ChannelSchedule* schedule = active;
+            if (schedule) schedule->service();
+        }
+        
+        bool isRunning() const { return running; }
+        uint16_t getPosition() const { return position; }
+        uint32_t getLoopCount() const { return loopCount; }
+        uint16_t size() const { return length; }
+        uint16_t getCapacity() const { return capacity; }
+    };
+
+    #if defined(__AVR__) && defined(MUXLIB_SCHEDULE_USE_TIMER1)
+    // Timer1 free-running at F_CPU/8, compare A marks the next deadline
+    #define MUXLIB_TIMER1_TICKS_PER_US (F_CPU / 8000000UL)
+
+    inline void ChannelSchedule::startTimer() {
+        TCCR1A = 0;
+        TCCR1B = (1 << CS11);
+        TIFR1 = (1 << OCF1A);
+    }
+
+    inline void ChannelSchedule::armTimer(uint32_t leadMicros) {
+        // Long dwells take several compare matches; service() re-arms until due
+        uint32_t ticks = leadMicros * MUXLIB_TIMER1_TICKS_PER_US;
+        if (ticks > 0xFFF0) ticks = 0xFFF0;
+        OCR1A = TCNT1 + (uint16_t)ticks;
+        TIFR1 = (1 << OCF1A);
+        TIMSK1 |= (1 << OCIE1A);
+    }
+
+    inline void ChannelSchedule::stopTimer() {
+        TIMSK1 &= ~(1 << OCIE1A);
+    }
+
+
+    ChannelSchedule* volatile ChannelSchedule::active = nullptr;
+    #endif
+}
+
+#if defined(__AVR__) && defined(MUXLIB_SCHEDULE_USE_TIMER1)
+ISR(TIMER1_COMPA_vect) {
+    MUXLib::ChannelSchedule::timerISR();
+}
+#endif
+
+#endif
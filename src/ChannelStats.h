@@ -0,0 +1,165 @@
+// Streaming Per-Channel Statistics (ChannelStats.h)
+#ifndef CHANNELSTATS_H
+#define CHANNELSTATS_H
+
+#include "MUXLib.h"
+#include "AnalogMUX.h"
+
+namespace MUXLib {
+    // Incremental statistics updated as samples arrive, so no history
+    // has to be stored or re-iterated by the application:
+    // - exponential moving average (integer, alpha = 1 / 2^emaShift)
+    // - running min/max
+    // - mean/variance (Welford)
+    // - fixed-window moving average (integer running sum)
+    class ChannelStats {
+    private:
+        struct ChannelState {
+            uint32_t emaScaled;     // EMA in 24.8 fixed point
+            uint32_t count;
+            float mean;
+            float m2;               // Sum of squared deviations (Welford)
+            uint32_t windowSum;
+            uint16_t minValue;
+            uint16_t maxValue;
+            uint8_t windowIndex;
+            uint8_t windowFill;
+        };
+        
+        ChannelState* channels;
+        uint16_t* windowBuffer;     // windowSize samples per channel
+        uint8_t numChannels;
+        uint8_t windowSize;
+        uint8_t emaShift;
+        
+    public:
+        ChannelStats(uint8_t channelCount, uint8_t window = 0, uint8_t emaShiftBits = 3)
+            : windowBuffer(nullptr), numChannels(channelCount), windowSize(window),
+              emaShift(emaShiftBits > 16 ? 16 : emaShiftBits) {
+            channels = (ChannelState*)malloc(channelCount * sizeof(ChannelState));
+            if (window) {
+                windowBuffer = (uint16_t*)malloc((uint16_t)channelCount * window * sizeof(uint16_t));
+            }
+            reset();
+        }
+        
+        ~ChannelStats() {
+            if (channels) free(channels);
+            if (windowBuffer) free(windowBuffer);
+        }
+        
+        MUXStatus begin() {
+            if (!channels || (windowSize && !windowBuffer)) return MUXStatus::ERROR_INIT;
+            reset();
+            return MUXStatus::OK;
+        }
+        
+        void reset() {
+            for (uint8_t ch = 0; ch < numChannels; ch++) {
+                reset(ch);
+            }
+        }
+        
+        void reset(uint8_t channel) {
+            if (!channels || channel >= numChannels) return;
+            memset(&channels[channel], 0, sizeof(ChannelState));
+            channels[channel].minValue = 0xFFFF;
+        }
+        
+        // Feed one sample into every statistic of a channel
+        void add(uint8_t channel, uint16_t value) {
+            if (!channels || channel >= numChannels) return;
+            ChannelState& s = channels[channel];
+            
+            // Exponential moving average, seeded with the first sample
+            uint32_t scaled = (uint32_t)value << 8;
+            if (s.count == 0) {
+                s.emaScaled = scaled;
+            } else if (scaled >= s.emaScaled) {
+                s.emaScaled += (scaled - s.emaScaled) >> emaShift;
+            } else {
+                s.emaScaled -= (s.emaScaled - scaled) >> emaShift;
+            }
+            
+            if (value < s.minValue) s.minValue = value;
+            if (value > s.maxValue) s.maxValue = value;
+            
+            // Welford's online mean/variance
+            s.count++;
+            float delta = value - s.mean;
+            s.mean += delta / s.count;
+            s.m2 += delta * (value - s.mean);
+            
+            // Moving window: replace the oldest sample in the running sum
+            if (windowBuffer) {
+                uint16_t* slot = &windowBuffer[(uint16_t)channel * windowSize + s.windowIndex];
+                if (s.windowFill == windowSize) {
+                    s.windowSum -= *slot;
+                } else {
+                    s.windowFill++;
+                }
+                *slot = value;
+                s.windowSum += value;
+                if (++s.windowIndex >= windowSize) s.windowIndex = 0;
+            }
+        }
+        
+        // Read one channel of an analog mux and record it
+        uint16_t sample(AnalogMUX& mux, uint8_t channel) {
+            uint16_t value = mux.readChannel(channel);
+            add(channel, value);
+            return value;
+        }
+        
+        // Read and record channels [0, channelCount)
+        void scan(AnalogMUX& mux) {
+            for (uint8_t ch = 0; ch < numChannels; ch++) {
+                sample(mux, ch);
+            }
+        }
+        
+        uint16_t getEMA(uint8_t channel) const {
+            if (!channels || channel >= numChannels) return 0;
+            return (channels[channel].emaScaled + 0x80) >> 8;
+        }
+        
+        uint16_t getMin(uint8_t channel) const {
+            if (!channels || channel >= numChannels || !channels[channel].count) return 0;
+            return channels[channel].minValue;
+        }
+        
+        uint16_t getMax(uint8_t channel) const {
+            if (!channels || channel >= numChannels) return 0;
+            return channels[channel].maxValue;
+        }
+        
+        float getMean(uint8_t channel) const {
+            if (!channels || channel >= numChannels) return 0;
+            return channels[channel].mean;
+        }
+        
+        // Sample variance (n - 1)
+        float getVariance(uint8_t channel) const {
+            if (!channels || channel >= numChannels || channels[channel].count < 2) return 0;
+            return channels[channel].m2 / (channels[channel].count - 1);
+        }
+        
+        float getStdDev(uint8_t channel) const {
+            return sqrt(getVariance(channel));
+        }
+        
+        // Average of the last 'window' samples (fewer until the window is full)
+        uint16_t getMovingAverage(uint8_t channel) const {
+            if (!channels || channel >= numChannels || !channels[channel].windowFill) return 0;
+            const ChannelState& s = channels[channel];
+            return (s.windowSum + s.windowFill / 2) / s.windowFill;
+        }
+        
+        uint32_t getCount(uint8_t channel) const {
+            if (!channels || channel >= numChannels) return 0;
+            return channels[channel].count;
+        }
+    };
+}
+
+#endif
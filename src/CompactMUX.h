@@ -0,0 +1,359 @@
+// Compact Multiplexer Core (CompactMUX.h)
+#ifndef COMPACTMUX_H
+#define COMPACTMUX_H
+
+#include "MUXLib.h"
+#include "AnalogMUX.h"
+
+// Template arguments of a CompactMUX for one of the AnalogMUX.h chip
+// descriptors, e.g. CompactMUX<MUXLIB_CHIP(CHIP_HC4051), WithPower>
+#define MUXLIB_CHIP(desc) (desc).selectPins, (desc).flags, (desc).pulseMicros, (desc).settleMicros
+
+namespace MUXLib {
+    // Called by WithScan after each channel it reads
+    typedef void (*ScanCallback)(uint8_t channel, uint16_t value);
+
+    // Parallel-addressed mux without a MUXManager base: no vtable, no heap,
+    // and only the state the chip needs (11 bytes for an HC4051 on AVR). The chip
+    // is fixed at compile time. Interrupts, scanning, diagnostics and power
+    // management are opt-in feature mixins:
+    //
+    //   CompactMUX<MUXLIB_CHIP(CHIP_HC4067)>                      bare
+    //   CompactMUX<MUXLIB_CHIP(CHIP_HC4067), WithPower, WithScan> with features
+    //
+    // A feature is a class template taking the final mux type. It reaches
+    // the mux through its public API and provides onSwitch(channel), called
+    // before every switch, and onSettle(us), called for every settling wait.
+    // Compact muxes do not derive from MUXManager, so they cannot be passed
+    // to PowerManager, MUXArbiter or other code holding MUXManager pointers.
+    template <uint8_t SelectPins, uint8_t Flags, uint8_t PulseMicros, uint16_t SettleMicros,
+              template <class> class... Features>
+    class CompactMUX : public Features<CompactMUX<SelectPins, Flags, PulseMicros, SettleMicros, Features...> >... {
+        static_assert(SelectPins >= 1 && SelectPins <= 5, "CompactMUX supports 1 to 5 select lines");
+        
+    private:
+        uint8_t selectPins[SelectPins];
+        uint8_t signalPin;
+        uint8_t enablePin;
+        uint8_t strobePin;
+        uint8_t currentChannel;
+        uint8_t selectState;        // Pattern currently driven on the select pins
+        bool enabled;
+        uint16_t settlingTime;      // microseconds
+        
+        static void wait(unsigned int us) {
+            #if defined(ESP8266) || defined(ESP32)
+                ets_delay_us(us);
+            #else
+                delayMicroseconds(us);
+            #endif
+        }
+        
+        void driveEnable(bool on) {
+            if (enablePin != 255) {
+                digitalWrite(enablePin, on == ((Flags & CHIP_ENABLE_HIGH) != 0));
+            }
+        }
+        
+        static uint8_t selectPattern(uint8_t channel) {
+            if (Flags & CHIP_SWAP_A0_A1) {
+                return (channel & ~0x03) | ((channel & 0x02) >> 1) | ((channel & 0x01) << 1);
+            }
+            return channel;
+        }
+        
+        void writeSelect(uint8_t pattern) {
+            uint8_t changed = pattern ^ selectState;
+            for (uint8_t i = 0; changed; i++, changed >>= 1) {
+                if (changed & 0x01) {
+                    digitalWrite(selectPins[i], (pattern >> i) & 0x01);
+                }
+            }
+            selectState = pattern;
+        }
+        
+        void notifySwitch(uint8_t channel) {
+            int expand[] = { 0, (Features<CompactMUX>::onSwitch(channel), 0)... };
+            (void)expand;
+        }
+        
+        void settle() {
+            int expand[] = { 0, (Features<CompactMUX>::onSettle(settlingTime), 0)... };
+            (void)expand;
+            wait(settlingTime);
+        }
+        
+    public:
+        static const uint8_t CHANNELS = 1 << SelectPins;
+        
+        CompactMUX(const uint8_t* selPins, uint8_t sigPin, uint8_t enPin = 255, uint8_t strbPin = 255)
+            : signalPin(sigPin), enablePin(enPin), strobePin(strbPin), currentChannel(0),
+              selectState(0), enabled(false), settlingTime(SettleMicros) {
+            memcpy(selectPins, selPins, SelectPins);
+        }
+        
+        MUXStatus begin() {
+            if ((Flags & CHIP_STROBE) && strobePin == 255) return MUXStatus::ERROR_INIT;
+            
+            for (uint8_t i = 0; i < SelectPins; i++) {
+                pinMode(selectPins[i], OUTPUT);
+                digitalWrite(selectPins[i], LOW);
+            }
+            selectState = 0;
+            
+            if (enablePin != 255) {
+                pinMode(enablePin, OUTPUT);
+                driveEnable(false);
+            }
+            if (Flags & CHIP_STROBE) {
+                pinMode(strobePin, OUTPUT);
+                digitalWrite(strobePin, HIGH);
+            }
+            if (signalPin != 255) {
+                pinMode(signalPin, INPUT);
+            }
+            
+            enabled = true;
+            return MUXStatus::OK;
+        }
+        
+        // Same switching sequence as AnalogMUX::setChannel()
+        MUXStatus setChannel(uint8_t channel) {
+            if (channel >= CHANNELS) return MUXStatus::ERROR_CHANNEL_INVALID;
+            if (!enabled) return MUXStatus::ERROR_NOT_ENABLED;
+            notifySwitch(channel);
+            
+            bool breakFirst = (Flags & CHIP_BREAK_BEFORE_MAKE) && enablePin != 255;
+            if (breakFirst) {
+                driveEnable(false);
+                wait(PulseMicros);
+            }
+            
+            writeSelect(selectPattern(channel));
+            
+            if (Flags & CHIP_STROBE) {
+                digitalWrite(strobePin, LOW);
+                wait(PulseMicros);
+                digitalWrite(strobePin, HIGH);
+            }
+            
+            if (breakFirst) wait(PulseMicros);
+            driveEnable(true);
+            
+            currentChannel = channel;
+            return MUXStatus::OK;
+        }
+        
+        uint8_t getChannel() const { return currentChannel; }
+        uint8_t getMaxChannels() const { return CHANNELS; }
+        
+        bool isEnabled() const { return enabled; }
+        void enable() { enabled = true; }
+        
+        // Also open the switch; the next setChannel() after enable() closes it
+        void disable() {
+            driveEnable(false);
+            enabled = false;
+        }
+        
+        // Drive every select line LOW (lowest leakage while idle)
+        void clearSelect() {
+            writeSelect(0);
+        }
+        
+        void setSettlingTime(uint16_t microseconds) { settlingTime = microseconds; }
+        
+        uint16_t readChannel(uint8_t channel) {
+            if (setChannel(channel) != MUXStatus::OK) return 0;
+            settle();
+            return analogRead(signalPin);
+        }
+        
+        bool readDigital(uint8_t channel) {
+            if (setChannel(channel) != MUXStatus::OK) return false;
+            settle();
+            return digitalRead(signalPin) == HIGH;
+        }
+    };
+
+    // Interrupt pin feature. The ISR only sets a flag; service() runs the
+    // handler from loop() with the channel selected at that time. The ISR
+    // holds the address of that flag, so a mux with this feature cannot be
+    // copied or moved.
+    template <class Mux>
+    class WithInterrupts {
+    private:
+        InterruptCallback handler;
+        volatile bool flag;
+        uint8_t pin;
+        uint8_t slot;
+        
+    protected:
+        void onSwitch(uint8_t channel) {}
+        void onSettle(uint16_t us) {}
+        
+    public:
+        WithInterrupts() : handler(nullptr), flag(false), pin(255), slot(255) {}
+        
+        WithInterrupts(const WithInterrupts&) = delete;
+        WithInterrupts& operator=(const WithInterrupts&) = delete;
+        
+        ~WithInterrupts() {
+            detachInterrupt();
+        }
+        
+        MUXStatus attachInterrupt(InterruptCallback callback, uint8_t interruptPin,
+                                  InterruptMode mode = InterruptMode::BOTH_EDGES) {
+            detachInterrupt();
+            MUXStatus status = attachFlagInterrupt(&flag, interruptPin, mode, slot);
+            if (status != MUXStatus::OK) return status;
+            
+            handler = callback;
+            pin = interruptPin;
+            return MUXStatus::OK;
+        }
+        
+        void detachInterrupt() {
+            if (slot == 255) return;
+            detachFlagInterrupt(pin, slot);
+            handler = nullptr;
+            pin = 255;
+            slot = 255;
+        }
+        
+        bool interruptPending() {
+            bool pending = flag;
+            flag = false;
+            return pending;
+        }
+        
+        // Returns true if an interrupt was pending
+        bool service() {
+            if (!interruptPending()) return false;
+            if (handler) handler(static_cast<Mux*>(this)->getChannel());
+            return true;
+        }
+    };
+
+    // Timed round-robin scan: update() from loop() reads the next channel
+    // once the interval has passed and hands the value to the callback
+    template <class Mux>
+    class WithScan {
+    private:
+        ScanCallback callback;
+        uint32_t lastStep;
+        uint16_t interval;      // milliseconds
+        uint8_t first;
+        uint8_t last;
+        uint8_t next;
+        bool scanning;
+        
+    protected:
+        void onSwitch(uint8_t channel) {}
+        void onSettle(uint16_t us) {}
+        
+    public:
+        WithScan() : callback(nullptr), lastStep(0), interval(100), first(0), last(0), next(0), scanning(false) {}
+        
+        // endChannel 255 = the last channel
+        bool startScan(uint8_t startChannel = 0, uint8_t endChannel = 255) {
+            Mux& mux = *static_cast<Mux*>(this);
+            if (endChannel == 255) endChannel = mux.getMaxChannels() - 1;
+            if (startChannel > endChannel || endChannel >= mux.getMaxChannels()) return false;
+            
+            first = startChannel;
+            last = endChannel;
+            next = startChannel;
+            lastStep = millis() - interval;
+            scanning = true;
+            return true;
+        }
+        
+        void stopScan() { scanning = false; }
+        bool isScanning() const { return scanning; }
+        void setScanInterval(uint16_t milliseconds) { interval = milliseconds; }
+        void onScan(ScanCallback scanCallback) { callback = scanCallback; }
+        
+        void update() {
+            if (!scanning || millis() - lastStep < interval) return;
+            lastStep = millis();
+            
+            uint8_t channel = next;
+            next = (next >= last) ? first : next + 1;
+            uint16_t value = static_cast<Mux*>(this)->readChannel(channel);
+            if (callback) callback(channel, value);
+        }
+    };
+
+    // Switch and settling counters, the GPIO subset of MUXDiagnostics
+    template <class Mux>
+    class WithDiagnostics {
+    private:
+        uint32_t switchCount;
+        uint32_t redundantSwitches;
+        uint32_t settleMicros;
+        
+    protected:
+        void onSwitch(uint8_t channel) {
+            if (switchCount && channel == static_cast<Mux*>(this)->getChannel()) {
+                redundantSwitches++;
+            }
+            switchCount++;
+        }
+        
+        void onSettle(uint16_t us) { settleMicros += us; }
+        
+    public:
+        WithDiagnostics() : switchCount(0), redundantSwitches(0), settleMicros(0) {}
+        
+        void getDiagnostics(MUXDiagnostics& snapshot) const {
+            memset(&snapshot, 0, sizeof(snapshot));
+            snapshot.switchCount = switchCount;
+            snapshot.redundantSwitches = redundantSwitches;
+            snapshot.settleMicros = settleMicros;
+        }
+        
+        void resetDiagnostics() {
+            switchCount = 0;
+            redundantSwitches = 0;
+            settleMicros = 0;
+        }
+    };
+
+    // sleep()/wake() as on AnalogMUX: open the switch and park the select
+    // lines LOW, then re-select the previous channel on wake
+    template <class Mux>
+    class WithPower {
+    private:
+        bool sleeping;
+        
+    protected:
+        void onSwitch(uint8_t channel) {}
+        void onSettle(uint16_t us) {}
+        
+    public:
+        WithPower() : sleeping(false) {}
+        
+        void sleep() {
+            Mux& mux = *static_cast<Mux*>(this);
+            if (sleeping || !mux.isEnabled()) return;
+            
+            mux.disable();
+            mux.clearSelect();
+            sleeping = true;
+        }
+        
+        void wake() {
+            if (!sleeping) return;
+            
+            Mux& mux = *static_cast<Mux*>(this);
+            sleeping = false;
+            mux.enable();
+            mux.setChannel(mux.getChannel());
+        }
+        
+        bool isSleeping() const { return sleeping; }
+    };
+}
+
+#endif
@@ -60,6 +60,57 @@ namespace MUXLib {
             }
             enabled = false;
         }
+        
+        // Select every channel and read the select lines back
+        bool runSelfTest(SelfTestResult& result) override {
+            memset(&result, 0, sizeof(result));
+            uint32_t start = micros();
+            uint8_t previous = currentChannel;
+            
+            for (uint8_t ch = 0; ch < maxChannels; ch++) {
+                bool ok = (setChannel(ch) == MUXStatus::OK);
+                for (uint8_t i = 0; ok && i < numSelectPins; i++) {
+                    if (selectPins[i] != 255 &&
+                        (digitalRead(selectPins[i]) != 0) != (bool)((ch >> i) & 0x01)) {
+                        ok = false;
+                    }
+                }
+                if (ok) {
+                    result.passMask |= (1UL << ch);
+                } else {
+                    result.failMask |= (1UL << ch);
+                }
+            }
+            
+            setChannel(previous);
+            result.durationMicros = micros() - start;
+            return result.failMask == 0;
+        }
+        
+        void sleep() override {
+            if (sleeping || !enabled) return;
+            
+            disable();
+            for (uint8_t i = 0; i < numSelectPins; i++) {
+                if (selectPins[i] != 255) {
+                    digitalWrite(selectPins[i], LOW);
+                }
+            }
+            sleeping = true;
+        }
+        
+        // Restore the select lines directly, then re-enable
+        void wake() override {
+            if (!sleeping) return;
+            
+            for (uint8_t i = 0; i < numSelectPins; i++) {
+                if (selectPins[i] != 255) {
+                    digitalWrite(selectPins[i], (currentChannel >> i) & 0x01);
+                }
+            }
+            sleeping = false;
+            enable();
+        }
     };
 
     // 74HC405X (4051/4052/4053) Multiplexer
@@ -76,6 +127,9 @@ namespace MUXLib {
         MUXStatus setChannel(uint8_t channel) override {
             if (!isValidChannel(channel)) return MUXStatus::ERROR_CHANNEL_INVALID;
             if (!enabled) return MUXStatus::ERROR_NOT_ENABLED;
+            MUXLIB_DIAG_SCOPE(setChannelHistogram);
+            MUXLIB_TRACE_SCOPE(channel);
+            MUXLIB_DIAG(diagSwitch(channel));
             
             for (uint8_t i = 0; i < numSelectPins; i++) {
                 digitalWrite(selectPins[i], (channel >> i) & 0x01);
@@ -125,13 +179,16 @@ namespace MUXLib {
         MUXStatus setChannel(uint8_t channel) override {
             if (!isValidChannel(channel)) return MUXStatus::ERROR_CHANNEL_INVALID;
             if (!enabled) return MUXStatus::ERROR_NOT_ENABLED;
+            MUXLIB_DIAG_SCOPE(setChannelHistogram);
+            MUXLIB_TRACE_SCOPE(channel);
+            MUXLIB_DIAG(diagSwitch(channel));
             
             for (uint8_t i = 0; i < 4; i++) {
                 digitalWrite(selectPins[i], (channel >> i) & 0x01);
             }
             
             if (autoRead && sigPin != 255 && channelValues) {
-                delayMicros(50); // Allow signal to settle
+                settle(50); // Allow signal to settle
                 channelValues[channel] = analogRead(sigPin);
             }
             
@@ -146,11 +203,14 @@ namespace MUXLib {
         }
         
         uint16_t readChannel(uint8_t channel) {
+            MUXLIB_DIAG_SCOPE(readChannelHistogram);
             if (sigPin == 255 || !isValidChannel(channel)) return 0;
             
             setChannel(channel);
-            delayMicros(50); // Allow signal to settle
-            return analogRead(sigPin);
+            settle(50); // Allow signal to settle
+            uint16_t value = analogRead(sigPin);
+            MUXLIB_TRACE(trace(TraceOp::SAMPLE, channel, 0, value));
+            return value;
         }
         
         uint16_t getChannelValue(uint8_t channel) {
@@ -174,6 +234,11 @@ namespace MUXLib {
         uint8_t mosiPin;
         uint8_t sckPin;
         
+        uint8_t shadowState;  // Last byte written to the device
+        
+        // Devices that can read their state back override this
+        virtual bool readbackState(uint8_t& state) { return false; }
+        
         void initSPI(uint8_t speed) {
             speedMHz = speed;
             #ifdef SPI_AVAILABLE
@@ -185,6 +250,7 @@ namespace MUXLib {
         }
         
         void spiTransfer(uint8_t data) {
+            shadowState = data;
             #ifdef SPI_AVAILABLE
                 if (useHardwareSPI) {
                     SPI.beginTransaction(spiSettings);
@@ -212,7 +278,7 @@ namespace MUXLib {
         SPIMUXBase(uint8_t cs, uint8_t maxChannels, bool hwSPI = true,
                    uint8_t mosi = 255, uint8_t sck = 255)
             : MUXManager(0, maxChannels), csPin(cs), speedMHz(10),
-              useHardwareSPI(hwSPI), mosiPin(mosi), sckPin(sck) {}
+              useHardwareSPI(hwSPI), mosiPin(mosi), sckPin(sck), shadowState(0) {}
               
         MUXStatus begin() override {
             pinMode(csPin, OUTPUT);
@@ -230,6 +296,46 @@ namespace MUXLib {
             return MUXStatus::OK;
         }
         
+        // Compare the device state with the shadow copy where readback exists
+        bool runSelfTest(SelfTestResult& result) override {
+            memset(&result, 0, sizeof(result));
+            uint32_t start = micros();
+            
+            uint8_t state;
+            if (readbackState(state)) {
+                if (state == shadowState) {
+                    result.passMask = 1;
+                } else {
+                    result.failMask = 1;
+                    MUXLIB_DIAG(diagBusError());
+                }
+            }
+            
+            result.durationMicros = micros() - start;
+            return result.failMask == 0;
+        }
+        
+        // Idle the bus lines; the device keeps its own state through sleep
+        void sleep() override {
+            if (sleeping || !enabled) return;
+            
+            digitalWrite(csPin, HIGH);
+            if (!useHardwareSPI) {
+                digitalWrite(mosiPin, LOW);
+                digitalWrite(sckPin, LOW);
+            }
+            
+            enabled = false;
+            sleeping = true;
+        }
+        
+        void wake() override {
+            if (!sleeping) return;
+            
+            sleeping = false;
+            enabled = true;
+        }
+        
         virtual void setSPISpeed(uint8_t speedMHz) {
             this->speedMHz = speedMHz;
             initSPI(speedMHz);
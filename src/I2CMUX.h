@@ -16,100 +16,152 @@
 #endif
 
 namespace MUXLib {
-    // TCA9548A I2C Multiplexer
-    class TCA9548A : public MUXManager {
-    private:
+    // One entry of a batched transfer list (see I2CMUXBase::transferAll()).
+    // Write 'out', then read into 'in'; either part may be empty.
+    struct I2CRequest {
+        uint8_t channel;
+        uint8_t address;
+        const uint8_t* out;
+        uint8_t outLength;
+        uint8_t* in;
+        uint8_t inLength;
+        MUXStatus status;   // Filled in by transferAll()
+    };
+
+    // Common base for I2C multiplexers driven through a single control register
+    class I2CMUXBase : public MUXManager {
+    protected:
         WIRE_IMPL* wire;
-        bool scanning;
-        uint32_t scanInterval;
-        uint32_t lastScanTime;
-        uint8_t scanStartCh;
-        uint8_t scanEndCh;
+        uint8_t resetPin;
+        bool routed;  // A channel has been selected since begin()
         
-    public:
-        TCA9548A(uint8_t address = 0x70, WIRE_IMPL* wirePort = &Wire) 
-            : MUXManager(address, 8), wire(wirePort), scanning(false),
-              scanInterval(100), lastScanTime(0), scanStartCh(0), scanEndCh(7) {}
+        // Bus recovery
+        uint8_t sdaPin;
+        uint8_t sclPin;
+        uint8_t quarantineMask;  // Channels found holding the bus, never selected again
+        bool autoRecover;
         
-        MUXStatus begin() override {
-            wire->begin();
+        // Per-channel bus clock, 0 = use busSpeed. The Wire clock is left
+        // alone until setI2CSpeed() or a channel speed is set.
+        uint16_t channelSpeedKHz[8];
+        uint32_t busSpeed;       // Clock of channels without their own speed
+        bool clockManaged;
+        
+        // Highest clock the mux itself supports
+        virtual uint32_t maxBusSpeed() const { return 400000UL; }
+        
+        uint32_t cappedSpeed(uint32_t speed) const {
+            return speed < maxBusSpeed() ? speed : maxBusSpeed();
+        }
+        
+        uint32_t effectiveSpeed(uint8_t channel) const {
+            return cappedSpeed(channelSpeedKHz[channel] ? channelSpeedKHz[channel] * 1000UL : busSpeed);
+        }
+        
+        // Clock last programmed into a Wire port, shared by every mux on
+        // that bus (0 = unknown). Ports beyond the table are never cached.
+        static uint32_t& busClock(WIRE_IMPL* port) {
+            struct Entry {
+                WIRE_IMPL* port;
+                uint32_t clock;
+            };
+            static Entry entries[4];
+            static uint32_t uncached;
             
-            wire->beginTransmission(deviceAddress);
-            if (wire->endTransmission() != 0) {
-                return MUXStatus::ERROR_INIT;
+            for (uint8_t i = 0; i < 4; i++) {
+                if (entries[i].port == port) return entries[i].clock;
             }
-            
-            enable();
-            return MUXStatus::OK;
+            for (uint8_t i = 0; i < 4; i++) {
+                if (!entries[i].port) {
+                    entries[i].port = port;
+                    entries[i].clock = 0;
+                    return entries[i].clock;
+                }
+            }
+            uncached = 0;
+            return uncached;
         }
         
-        MUXStatus setChannel(uint8_t channel) override {
-            if (!isValidChannel(channel)) return MUXStatus::ERROR_CHANNEL_INVALID;
-            if (!enabled) return MUXStatus::ERROR_NOT_ENABLED;
-            
+        void applySpeed(uint32_t frequency, bool force = false) {
+            if (!clockManaged) return;
+            uint32_t& clock = busClock(wire);
+            if (force || frequency != clock) {
+                wire->setClock(frequency);
+                clock = frequency;
+            }
+        }
+        
+        // Control register value that routes the given channel
+        virtual uint8_t channelControl(uint8_t channel) const = 0;
+        
+        // Control register bits that read back what was written
+        virtual uint8_t controlReadMask() const { return 0xFF; }
+        
+        MUXStatus writeControl(uint8_t value) {
+            MUXLIB_TRACE(uint32_t traceStart = micros());
             wire->beginTransmission(deviceAddress);
-            wire->write(1 << channel);
-            if (wire->endTransmission() != 0) {
+            wire->write(value);
+            uint8_t result = wire->endTransmission();
+            MUXLIB_TRACE(trace(TraceOp::I2C, deviceAddress, result, micros() - traceStart));
+            if (result != 0) {
+                MUXLIB_DIAG(diagBusError());
                 return MUXStatus::ERROR_COMMUNICATION;
             }
-            
-            currentChannel = channel;
             return MUXStatus::OK;
         }
         
-        bool startScan(uint8_t startChannel = 0, uint8_t endChannel = 7) override {
-            if (!isValidChannel(startChannel) || !isValidChannel(endChannel)) {
-                return false;
+        MUXStatus readControl(uint8_t& value) {
+            MUXLIB_TRACE(uint32_t traceStart = micros());
+            uint8_t received = wire->requestFrom(deviceAddress, (uint8_t)1);
+            MUXLIB_TRACE(trace(TraceOp::I2C, deviceAddress | 0x80, received == 1 ? 0 : 2,
+                               micros() - traceStart));
+            if (received != 1) {
+                MUXLIB_DIAG(diagBusError());
+                return MUXStatus::ERROR_COMMUNICATION;
             }
-            scanning = true;
-            scanStartCh = startChannel;
-            scanEndCh = endChannel;
-            currentChannel = startChannel - 1;  // Will increment to start on first update
-            return true;
+            value = wire->read();
+            return MUXStatus::OK;
         }
         
-        void stopScan() override {
-            scanning = false;
+        // Address-only transfer: does the mux still ACK on the upstream bus?
+        bool probe() {
+            wire->beginTransmission(deviceAddress);
+            return wire->endTransmission() == 0;
         }
         
-        void update() {
-            if (scanning && (millis() - lastScanTime >= scanInterval)) {
-                currentChannel++;
-                if (currentChannel > scanEndCh || currentChannel < scanStartCh) {
-                    currentChannel = scanStartCh;
-                }
-                setChannel(currentChannel);
-                lastScanTime = millis();
-            }
+        // Open-drain emulation for bit-banging SDA/SCL
+        void driveLow(uint8_t pin) {
+            digitalWrite(pin, LOW);
+            pinMode(pin, OUTPUT);
         }
         
-        void setScanInterval(uint32_t interval) {
-            scanInterval = interval;
+        void release(uint8_t pin) {
+            pinMode(pin, INPUT_PULLUP);
         }
-
-        // Platform specific I2C speed control
-        void setI2CSpeed(uint32_t frequency) {
-            #if defined(ESP8266) || defined(ESP32)
-                wire->setClock(frequency);
-            #else
-                // Standard Arduino Wire library doesn't support dynamic clock speed
-                // Could add platform specific implementations here
-            #endif
+        
+        // A reset pin or the bus pins are needed to free a stuck bus; a
+        // control register write alone goes over the stuck bus itself
+        bool canRecover() const {
+            return resetPin != 255 || (sdaPin != 255 && sclPin != 255);
+        }
+        
+        // Both lines idle high (falls back to an ACK probe without bus pins)
+        bool busReleased() {
+            if (sdaPin == 255 || sclPin == 255) return probe();
+            return digitalRead(sdaPin) == HIGH && digitalRead(sclPin) == HIGH && probe();
         }
-    };
-
-    // PCA9547 I2C Multiplexer
-    class PCA9547 : public MUXManager {
-    private:
-        WIRE_IMPL* wire;
-        uint8_t resetPin;
         
     public:
-        PCA9547(uint8_t address = 0x70, uint8_t rstPin = 255, WIRE_IMPL* wirePort = &Wire) 
-            : MUXManager(address, 8), wire(wirePort), resetPin(rstPin) {}
+        I2CMUXBase(uint8_t address, uint8_t channels, WIRE_IMPL* wirePort, uint8_t rstPin = 255)
+            : MUXManager(address, channels), wire(wirePort), resetPin(rstPin), routed(false),
+              sdaPin(255), sclPin(255), quarantineMask(0), autoRecover(false),
+              busSpeed(100000UL), clockManaged(false) {
+            memset(channelSpeedKHz, 0, sizeof(channelSpeedKHz));
+        }
             
         MUXStatus begin() override {
             wire->begin();
+            applySpeed(cappedSpeed(busSpeed), true);
             
             if (resetPin != 255) {
                 pinMode(resetPin, OUTPUT);
@@ -128,92 +180,616 @@ namespace MUXLib {
         MUXStatus setChannel(uint8_t channel) override {
             if (!isValidChannel(channel)) return MUXStatus::ERROR_CHANNEL_INVALID;
             if (!enabled) return MUXStatus::ERROR_NOT_ENABLED;
+            if (isQuarantined(channel)) return MUXStatus::ERROR_COMMUNICATION;
+            MUXLIB_DIAG_SCOPE(setChannelHistogram);
+            MUXLIB_TRACE_SCOPE(channel);
+            MUXLIB_DIAG(diagSwitch(channel));
             
-            wire->beginTransmission(deviceAddress);
-            wire->write(channel | 0x08); // Set enable bit
-            if (wire->endTransmission() != 0) {
-                return MUXStatus::ERROR_COMMUNICATION;
+            // The select write is seen by the devices on both the old and the
+            // new channel, so it goes out at the slower of the two clocks
+            uint32_t target = effectiveSpeed(channel);
+            uint32_t selectSpeed = routed ? effectiveSpeed(currentChannel) : cappedSpeed(busSpeed);
+            applySpeed(selectSpeed < target ? selectSpeed : target);
+            
+            MUXStatus status = writeControl(channelControl(channel));
+            if (status != MUXStatus::OK && autoRecover &&
+                recoverBus() == MUXStatus::OK && !isQuarantined(channel)) {
+                status = writeControl(channelControl(channel));
             }
+            if (status != MUXStatus::OK) return MUXLIB_TRACE_RESULT(status);
             
+            applySpeed(target);
             currentChannel = channel;
+            routed = true;
+            return MUXStatus::OK;
+        }
+        
+        // Write then read a device behind the mux; either part may be
+        // empty. The select is skipped while the channel is routed. Where
+        // the Wire backend supports combined transfers (MUXLIB_WIRE_TRANSFER)
+        // select, write and read go out as one request. With auto-recovery
+        // on, the select goes through setChannel() instead, so a stuck bus
+        // is recovered the same way on every backend.
+        MUXStatus transfer(uint8_t channel, uint8_t address, const uint8_t* out, uint8_t outLength,
+                           uint8_t* in = nullptr, uint8_t inLength = 0) {
+            if (!isValidChannel(channel)) return MUXStatus::ERROR_CHANNEL_INVALID;
+            if (!enabled) return MUXStatus::ERROR_NOT_ENABLED;
+            if (isQuarantined(channel)) return MUXStatus::ERROR_COMMUNICATION;
+            bool select = !routed || currentChannel != channel;
+            
+            #if defined(MUXLIB_WIRE_TRANSFER)
+            if (select && autoRecover) {
+                MUXStatus status = setChannel(channel);
+                if (status != MUXStatus::OK) return status;
+                select = false;
+            }
+            
+            uint8_t control = channelControl(channel);
+            I2CSegment segments[3];
+            uint8_t count = 0;
+            if (select) segments[count++] = { deviceAddress, false, &control, 1, true };
+            if (outLength) segments[count++] = { address, false, (uint8_t*)out, outLength, inLength == 0 };
+            if (inLength) segments[count++] = { address, true, in, inLength, true };
+            
+            MUXLIB_TRACE(uint32_t traceStart = micros());
+            uint8_t result = wire->transfer(segments, count);
+            MUXLIB_TRACE(trace(TraceOp::I2C, address, result, micros() - traceStart));
+            if (select) {
+                MUXLIB_DIAG(diagSwitch(channel));
+                if (result != 0) {
+                    routed = false;  // The select may or may not have landed
+                } else {
+                    currentChannel = channel;
+                    routed = true;
+                }
+            }
+            if (result != 0) {
+                MUXLIB_DIAG(diagBusError());
+                return MUXStatus::ERROR_COMMUNICATION;
+            }
             return MUXStatus::OK;
+            #else
+            if (select) {
+                MUXStatus status = setChannel(channel);
+                if (status != MUXStatus::OK) return status;
+            }
+            
+            if (outLength) {
+                wire->beginTransmission(address);
+                wire->write(out, outLength);
+                if (wire->endTransmission(inLength == 0) != 0) {
+                    MUXLIB_DIAG(diagBusError());
+                    return MUXStatus::ERROR_COMMUNICATION;
+                }
+            }
+            if (inLength) {
+                if (wire->requestFrom(address, inLength) != inLength) {
+                    MUXLIB_DIAG(diagBusError());
+                    return MUXStatus::ERROR_COMMUNICATION;
+                }
+                for (uint8_t i = 0; i < inLength; i++) {
+                    in[i] = wire->read();
+                }
+            }
+            return MUXStatus::OK;
+            #endif
+        }
+        
+        MUXStatus writeTo(uint8_t channel, uint8_t address, const uint8_t* data, uint8_t length) {
+            return transfer(channel, address, data, length);
+        }
+        
+        // Register read: write 'reg', then read 'length' bytes
+        MUXStatus readFrom(uint8_t channel, uint8_t address, uint8_t reg, uint8_t* buffer, uint8_t length) {
+            return transfer(channel, address, &reg, 1, buffer, length);
+        }
+        
+        MUXStatus readFrom(uint8_t channel, uint8_t address, uint8_t* buffer, uint8_t length) {
+            return transfer(channel, address, nullptr, 0, buffer, length);
+        }
+        
+        // Run a list of requests with one select per channel used: the
+        // routed channel first, then the others in ascending order. Requests
+        // on the same channel keep their relative order. Returns the number
+        // that failed; each request's status says which.
+        uint8_t transferAll(I2CRequest* requests, uint8_t count) {
+            uint8_t first = routed ? currentChannel : 0;
+            for (uint8_t i = 0; i < count; i++) {
+                requests[i].status = MUXStatus::ERROR_CHANNEL_INVALID;
+            }
+            
+            for (uint8_t pass = 0; pass <= maxChannels; pass++) {
+                uint8_t channel = (pass == 0) ? first : pass - 1;
+                if (pass > 0 && channel == first) continue;
+                
+                for (uint8_t i = 0; i < count; i++) {
+                    I2CRequest& r = requests[i];
+                    if (r.channel != channel) continue;
+                    r.status = transfer(channel, r.address, r.out, r.outLength, r.in, r.inLength);
+                }
+            }
+            
+            uint8_t failures = 0;
+            for (uint8_t i = 0; i < count; i++) {
+                if (requests[i].status != MUXStatus::OK) failures++;
+            }
+            return failures;
         }
         
+        // Disconnect every downstream channel (control register = 0)
+        void sleep() override {
+            if (sleeping || !enabled) return;
+            
+            if (writeControl(0x00) == MUXStatus::OK) {
+                enabled = false;
+                sleeping = true;
+            }
+        }
+        
+        // Re-route the channel selected before sleep() with a single write
+        void wake() override {
+            if (!sleeping) return;
+            
+            sleeping = false;
+            enabled = true;
+            if (routed) {
+                writeControl(channelControl(currentChannel));
+            }
+        }
+        
+        // Write every channel pattern (and all-off) to the control register
+        // and read it back. Bit n of the masks is channel n, bit 'channels'
+        // is the all-off pattern. The previous routing is restored.
+        bool runSelfTest(SelfTestResult& result) override {
+            memset(&result, 0, sizeof(result));
+            uint32_t start = micros();
+            
+            for (uint8_t pattern = 0; pattern <= maxChannels; pattern++) {
+                if (pattern < maxChannels && isQuarantined(pattern)) {
+                    result.failMask |= (1UL << pattern);
+                    continue;
+                }
+                uint8_t expected = (pattern < maxChannels) ? channelControl(pattern) : 0x00;
+                uint8_t actual;
+                
+                if (writeControl(expected) == MUXStatus::OK &&
+                    readControl(actual) == MUXStatus::OK &&
+                    ((actual ^ expected) & controlReadMask()) == 0) {
+                    result.passMask |= (1UL << pattern);
+                } else {
+                    result.failMask |= (1UL << pattern);
+                }
+            }
+            
+            writeControl(routed ? channelControl(currentChannel) : 0x00);
+            result.durationMicros = micros() - start;
+            return result.failMask == 0;
+        }
+        
+        // Return the mux to its power-on state (all channels off). Without a
+        // reset pin the control register is cleared over the bus instead.
         void reset() {
             if (resetPin != 255) {
                 digitalWrite(resetPin, LOW);
                 delayMicros(1);
                 digitalWrite(resetPin, HIGH);
                 delayMicros(1);
+            } else {
+                writeControl(0x00);
             }
+            routed = false;
         }
-
-        // Platform specific I2C speed control
-        void setI2CSpeed(uint32_t frequency) {
-            #if defined(ESP8266) || defined(ESP32)
-                wire->setClock(frequency);
-            #endif
+        
+        // Pins used to bit-bang bus recovery (Wire does not expose them)
+        void setBusPins(uint8_t sda, uint8_t scl) {
+            sdaPin = sda;
+            sclPin = scl;
         }
-    };
-
-    // PCA9646 I2C Multiplexer with Voltage Translation
-    class PCA9646 : public MUXManager {
-    private:
-        WIRE_IMPL* wire;
-        uint8_t resetPin;
-        uint8_t voltageLevel;  // Stored voltage level (for reference only)
         
-    public:
-        PCA9646(uint8_t address = 0x70, uint8_t rstPin = 255, WIRE_IMPL* wirePort = &Wire) 
-            : MUXManager(address, 4), wire(wirePort), resetPin(rstPin), voltageLevel(33) {}
+        // Run recoverBus() automatically when a channel switch fails
+        void setAutoRecover(bool enable) {
+            autoRecover = enable;
+        }
+        
+        // Free a bus held low by a device stuck mid-transfer: clock SCL until
+        // SDA is released (at most 9 pulses), then issue a STOP condition.
+        // Returns true if SDA is high afterwards.
+        bool clearBus() {
+            if (sdaPin == 255 || sclPin == 255) return false;
             
-        MUXStatus begin() override {
+            #if !defined(ESP8266)
+                wire->end();
+            #endif
+            release(sdaPin);
+            release(sclPin);
+            delayMicros(5);
+            
+            for (uint8_t i = 0; i < 9 && digitalRead(sdaPin) == LOW; i++) {
+                driveLow(sclPin);
+                delayMicros(5);
+                release(sclPin);
+                delayMicros(5);
+            }
+            
+            // STOP: SDA rises while SCL is high
+            driveLow(sdaPin);
+            delayMicros(5);
+            release(sdaPin);
+            delayMicros(5);
+            
+            bool released = (digitalRead(sdaPin) == HIGH);
             wire->begin();
             
-            if (resetPin != 255) {
-                pinMode(resetPin, OUTPUT);
-                digitalWrite(resetPin, HIGH);
+            // Wire.begin() may reset the clock; restore the last one programmed
+            uint32_t clock = busClock(wire);
+            if (clock) {
+                wire->setClock(clock);
+            } else {
+                applySpeed(cappedSpeed(busSpeed), true);
             }
+            return released;
+        }
+        
+        // Connect each channel on its own and quarantine the ones that leave
+        // the bus stuck. Every channel is disconnected afterwards.
+        // Returns the number of newly quarantined channels. Without a reset
+        // pin or bus pins an offender cannot be disconnected again, so
+        // nothing is tested or quarantined.
+        uint8_t isolateStuckChannels() {
+            if (!canRecover()) return 0;
+            uint8_t found = 0;
             
-            wire->beginTransmission(deviceAddress);
-            if (wire->endTransmission() != 0) {
-                return MUXStatus::ERROR_INIT;
+            for (uint8_t ch = 0; ch < maxChannels; ch++) {
+                if (isQuarantined(ch)) continue;
+                
+                if (writeControl(channelControl(ch)) == MUXStatus::OK && busReleased()) {
+                    continue;
+                }
+                
+                quarantineMask |= (1 << ch);
+                found++;
+                
+                // Disconnect the offender before testing the next channel
+                clearBus();
+                reset();
+                if (!busReleased()) {
+                    clearBus();
+                    reset();
+                }
             }
             
-            enable();
-            return MUXStatus::OK;
+            writeControl(0x00);
+            routed = false;
+            return found;
         }
         
-        MUXStatus setChannel(uint8_t channel) override {
-            if (!isValidChannel(channel)) return MUXStatus::ERROR_CHANNEL_INVALID;
-            if (!enabled) return MUXStatus::ERROR_NOT_ENABLED;
+        // Full recovery: clear the bus, reset the mux, find and quarantine
+        // stuck channels, then restore the previous routing if still allowed.
+        // Fails without touching the quarantine if neither a reset pin nor
+        // the bus pins are set.
+        MUXStatus recoverBus() {
+            if (!canRecover()) return MUXStatus::ERROR_COMMUNICATION;
+            uint8_t previous = currentChannel;
+            bool wasRouted = routed;
             
-            wire->beginTransmission(deviceAddress);
-            wire->write(1 << channel);
-            if (wire->endTransmission() != 0) {
-                return MUXStatus::ERROR_COMMUNICATION;
+            clearBus();
+            reset();
+            if (!busReleased()) {
+                // The stuck device may have clocked out another bit on reset
+                clearBus();
+                if (!busReleased()) return MUXStatus::ERROR_COMMUNICATION;
             }
             
-            currentChannel = channel;
+            isolateStuckChannels();
+            
+            if (wasRouted && !isQuarantined(previous)) {
+                MUXStatus status = writeControl(channelControl(previous));
+                if (status != MUXStatus::OK) return status;
+                routed = true;
+            }
             return MUXStatus::OK;
         }
         
+        bool isQuarantined(uint8_t channel) const {
+            return channel < 8 && (quarantineMask & (1 << channel));
+        }
+        
+        uint8_t getQuarantineMask() const { return quarantineMask; }
+        
+        // Allow a repaired channel to be selected again
+        void clearQuarantine(uint8_t channel) {
+            if (channel < 8) quarantineMask &= ~(1 << channel);
+        }
+        
+        void clearQuarantine() {
+            quarantineMask = 0;
+        }
+        
+        // Default bus clock, used for channels without their own speed.
+        // Always reprograms Wire, so call it again after other code has
+        // changed the clock with Wire.setClock().
+        void setI2CSpeed(uint32_t frequency) {
+            busSpeed = frequency;
+            clockManaged = true;
+            applySpeed(routed ? effectiveSpeed(currentChannel) : cappedSpeed(busSpeed), true);
+        }
+        
+        // Maximum clock for the devices on one channel (0 = default). The
+        // clock is switched automatically by setChannel(), capped at the
+        // highest speed the mux itself supports.
+        void setChannelSpeed(uint8_t channel, uint32_t frequency) {
+            if (!isValidChannel(channel)) return;
+            channelSpeedKHz[channel] = frequency / 1000;
+            clockManaged = true;
+            if (routed && channel == currentChannel) {
+                applySpeed(effectiveSpeed(channel));
+            }
+        }
+        
+        uint32_t getChannelSpeed(uint8_t channel) const {
+            return isValidChannel(channel) ? effectiveSpeed(channel) : 0;
+        }
+        
+        // Find the fastest clock (1 MHz, 400 kHz, 100 kHz) at which every
+        // listed device on a channel ACKs reliably, and store it for that
+        // channel. Returns the chosen frequency, 0 if no device answered.
+        uint32_t probeChannelSpeed(uint8_t channel, const uint8_t* addresses, uint8_t count) {
+            static const uint32_t candidates[] = { 1000000UL, 400000UL, 100000UL };
+            if (!isValidChannel(channel)) return 0;
+            
+            channelSpeedKHz[channel] = 100;
+            clockManaged = true;
+            if (setChannel(channel) != MUXStatus::OK) return 0;
+            
+            uint32_t chosen = 0;
+            for (uint8_t c = 0; c < 3 && !chosen; c++) {
+                if (candidates[c] > maxBusSpeed()) continue;
+                applySpeed(candidates[c]);
+                
+                bool allAck = true;
+                for (uint8_t i = 0; i < count && allAck; i++) {
+                    for (uint8_t attempt = 0; attempt < 3 && allAck; attempt++) {
+                        wire->beginTransmission(addresses[i]);
+                        allAck = (wire->endTransmission() == 0);
+                    }
+                }
+                if (allAck) chosen = candidates[c];
+            }
+            
+            channelSpeedKHz[channel] = chosen / 1000;
+            applySpeed(effectiveSpeed(channel));
+            return chosen;
+        }
+        
+        uint32_t probeChannelSpeed(uint8_t channel, uint8_t address) {
+            return probeChannelSpeed(channel, &address, 1);
+        }
+    };
+
+    // TCA9548A I2C Multiplexer
+    class TCA9548A : public I2CMUXBase {
+    private:
+        bool scanning;
+        uint32_t scanInterval;
+        uint32_t lastScanTime;
+        uint8_t scanStartCh;
+        uint8_t scanEndCh;
+        uint8_t scanNext;       // Channel the next update() selects
+        
+    protected:
+        uint8_t channelControl(uint8_t channel) const override {
+            return 1 << channel;
+        }
+        
+    public:
+        TCA9548A(uint8_t address = 0x70, WIRE_IMPL* wirePort = &Wire) 
+            : I2CMUXBase(address, 8, wirePort), scanning(false),
+              scanInterval(100), lastScanTime(0), scanStartCh(0), scanEndCh(7), scanNext(0) {}
+        
+        // The routed channel only changes when update() selects the next
+        // one, so transfers in between still go where the mux points
+        bool startScan(uint8_t startChannel = 0, uint8_t endChannel = 7) override {
+            if (!isValidChannel(startChannel) || !isValidChannel(endChannel)) {
+                return false;
+            }
+            scanning = true;
+            scanStartCh = startChannel;
+            scanEndCh = endChannel;
+            scanNext = startChannel;
+            return true;
+        }
+        
+        void stopScan() override {
+            scanning = false;
+        }
+        
+        void update() {
+            if (scanning && (millis() - lastScanTime >= scanInterval)) {
+                // Skip quarantined channels, give up if they all are
+                uint8_t channel = scanNext;
+                for (uint8_t tries = 0; tries < maxChannels && isQuarantined(channel); tries++) {
+                    channel = (channel >= scanEndCh || channel < scanStartCh) ? scanStartCh : channel + 1;
+                }
+                if (!isQuarantined(channel)) {
+                    setChannel(channel);
+                    scanNext = (channel >= scanEndCh || channel < scanStartCh) ? scanStartCh : channel + 1;
+                }
+                lastScanTime = millis();
+            }
+        }
+        
+        void setScanInterval(uint32_t interval) {
+            scanInterval = interval;
+        }
+    };
+
+    // PCA9547 I2C Multiplexer
+    class PCA9547 : public I2CMUXBase {
+    protected:
+        uint8_t channelControl(uint8_t channel) const override {
+            return channel | 0x08; // Set enable bit
+        }
+        
+        uint8_t controlReadMask() const override { return 0x0F; }
+        
+    public:
+        PCA9547(uint8_t address = 0x70, uint8_t rstPin = 255, WIRE_IMPL* wirePort = &Wire) 
+            : I2CMUXBase(address, 8, wirePort, rstPin) {}
+    };
+
+    // PCA9646 I2C Multiplexer with Voltage Translation
+    class PCA9646 : public I2CMUXBase {
+    private:
+        uint8_t voltageLevel;  // Stored voltage level (for reference only)
+        
+    protected:
+        uint8_t channelControl(uint8_t channel) const override {
+            return 1 << channel;
+        }
+        
+        uint8_t controlReadMask() const override { return 0x0F; }
+        
+        // Fast-mode Plus capable
+        uint32_t maxBusSpeed() const override { return 1000000UL; }
+        
+    public:
+        PCA9646(uint8_t address = 0x70, uint8_t rstPin = 255, WIRE_IMPL* wirePort = &Wire) 
+            : I2CMUXBase(address, 4, wirePort, rstPin), voltageLevel(33) {}
+        
         // Set voltage level (1.8V = 18, 2.5V = 25, 3.3V = 33, 5V = 50)
         void setVoltageLevel(uint8_t level) {
             voltageLevel = level;
             // Note: Actual voltage level is set by hardware pins
             // This is just for reference
         }
+    };
 
-        void reset() {
-            if (resetPin != 255) {
-                digitalWrite(resetPin, LOW);
-                delayMicros(1);
-                digitalWrite(resetPin, HIGH);
-                delayMicros(1);
+    // A device behind one channel of an I2C mux. Driver code keeps a route
+    // instead of a Wire pointer and never selects the channel itself.
+    class I2CRoute {
+    private:
+        I2CMUXBase* mux;
+        uint8_t channel;
+        uint8_t address;
+        
+    public:
+        I2CRoute(I2CMUXBase& muxRef, uint8_t ch, uint8_t addr)
+            : mux(&muxRef), channel(ch), address(addr) {}
+            
+        MUXStatus write(const uint8_t* data, uint8_t length) {
+            return mux->writeTo(channel, address, data, length);
+        }
+        
+        MUXStatus writeRegister(uint8_t reg, uint8_t value) {
+            uint8_t data[2] = { reg, value };
+            return mux->writeTo(channel, address, data, 2);
+        }
+        
+        MUXStatus read(uint8_t reg, uint8_t* buffer, uint8_t length) {
+            return mux->readFrom(channel, address, reg, buffer, length);
+        }
+        
+        MUXStatus read(uint8_t* buffer, uint8_t length) {
+            return mux->readFrom(channel, address, buffer, length);
+        }
+        
+        uint8_t getChannel() const { return channel; }
+        uint8_t getAddress() const { return address; }
+    };
+
+    // Base for interrupt-aggregating I2C muxes (PCA9544A, PCA9545A).
+    // Each downstream channel has an INT input; the mux ORs them onto its
+    // INT output and reports which ones are asserted in bits 4-7 of the
+    // control register. Attach the INT output with attachInterrupt() and
+    // call service() from loop(): the status register is read once and only
+    // the channels that raised an interrupt are selected and handled.
+    class InterruptI2CMUX : public I2CMUXBase {
+    protected:
+        InterruptCallback channelHandlers[4];
+        
+        // Bits 4-7 are the live INT status, not written state
+        uint8_t controlReadMask() const override { return 0x0F; }
+        
+    public:
+        InterruptI2CMUX(uint8_t address, WIRE_IMPL* wirePort, uint8_t rstPin = 255)
+            : I2CMUXBase(address, 4, wirePort, rstPin) {
+            for (uint8_t i = 0; i < 4; i++) {
+                channelHandlers[i] = nullptr;
+            }
+        }
+        
+        // Handler run (from service()) with the channel already selected
+        void attachChannelHandler(uint8_t channel, InterruptCallback handler) {
+            if (isValidChannel(channel)) {
+                channelHandlers[channel] = handler;
+            }
+        }
+        
+        // Pending downstream interrupts, bit n = channel n
+        MUXStatus readInterruptStatus(uint8_t& pending) {
+            uint8_t control;
+            MUXStatus status = readControl(control);
+            if (status != MUXStatus::OK) return status;
+            
+            pending = (control >> 4) & 0x0F;
+            return MUXStatus::OK;
+        }
+        
+        // Service the channels that raised an interrupt. Without an attached
+        // INT pin (or with force) the status register is polled instead.
+        // Returns the number of channels serviced.
+        uint8_t service(bool force = false) {
+            if (!force && interruptPin != 255 && !interruptPending()) return 0;
+            if (!enabled) return 0;
+            
+            uint8_t pending;
+            if (readInterruptStatus(pending) != MUXStatus::OK) return 0;
+            
+            uint8_t serviced = 0;
+            for (uint8_t ch = 0; ch < maxChannels; ch++) {
+                if (!(pending & (1 << ch)) || isQuarantined(ch)) continue;
+                if (setChannel(ch) != MUXStatus::OK) continue;
+                if (channelHandlers[ch]) {
+                    channelHandlers[ch](ch);
+                }
+                serviced++;
             }
+            
+            // INT is level triggered: if a device is still asserting it the
+            // falling edge will not repeat, so keep the flag for the next call
+            if (interruptPin != 255 && digitalRead(interruptPin) == LOW) {
+                interruptFlag = true;
+            }
+            
+            return serviced;
         }
     };
+
+    // PCA9544A 4-channel I2C multiplexer with interrupt logic
+    class PCA9544A : public InterruptI2CMUX {
+    protected:
+        uint8_t channelControl(uint8_t channel) const override {
+            return channel | 0x04; // Set enable bit
+        }
+        
+        uint8_t controlReadMask() const override { return 0x07; }
+        
+    public:
+        PCA9544A(uint8_t address = 0x70, uint8_t rstPin = 255, WIRE_IMPL* wirePort = &Wire)
+            : InterruptI2CMUX(address, wirePort, rstPin) {}
+    };
+
+    // PCA9545A 4-channel I2C switch with interrupt logic
+    class PCA9545A : public InterruptI2CMUX {
+    protected:
+        uint8_t channelControl(uint8_t channel) const override {
+            return 1 << channel;
+        }
+        
+    public:
+        PCA9545A(uint8_t address = 0x70, uint8_t rstPin = 255, WIRE_IMPL* wirePort = &Wire)
+            : InterruptI2CMUX(address, wirePort, rstPin) {}
+    };
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,356 @@
+// Shared MUX Access from Several Tasks (MUXLease.h)
+#ifndef MUXLEASE_H
+#define MUXLEASE_H
+
+#include "MUXLib.h"
+
+#if defined(ESP32)
+    #include "freertos/FreeRTOS.h"
+    #include "freertos/task.h"
+#elif defined(MUXLIB_HOST)
+    #include <mutex>
+    #include <condition_variable>
+#endif
+
+// Tasks that can wait on one arbiter at the same time
+#ifndef MUXLIB_MAX_LEASE_WAITERS
+    #define MUXLIB_MAX_LEASE_WAITERS 8
+#endif
+
+#define MUXLIB_WAIT_FOREVER 0xFFFFFFFFUL
+
+namespace MUXLib {
+    // Lock and wait/wake primitives behind MUXArbiter:
+    // - ESP32: spinlock critical section (valid across both cores), task notifications
+    // - host: std::mutex and std::condition_variable
+    // - elsewhere: single-threaded, so nothing to lock and nobody to wait for
+    class LeaseLock {
+    public:
+        #if defined(ESP32)
+        typedef TaskHandle_t WakeToken;
+        #else
+        typedef uint8_t WakeToken;
+        #endif
+        
+        struct Waiter {
+            uint8_t channel;
+            uint8_t priority;
+            volatile bool granted;
+            MUXStatus status;
+            WakeToken token;
+        };
+        
+    private:
+        #if defined(ESP32)
+        portMUX_TYPE spinlock;
+        #elif defined(MUXLIB_HOST)
+        std::mutex mutex;
+        std::condition_variable wakeup;
+        #endif
+        
+    public:
+        LeaseLock() {
+            #if defined(ESP32)
+            spinlock = portMUX_INITIALIZER_UNLOCKED;
+            #endif
+        }
+        
+        void lock() {
+            #if defined(ESP32)
+            portENTER_CRITICAL(&spinlock);
+            #elif defined(MUXLIB_HOST)
+            mutex.lock();
+            #endif
+        }
+        
+        void unlock() {
+            #if defined(ESP32)
+            portEXIT_CRITICAL(&spinlock);
+            #elif defined(MUXLIB_HOST)
+            mutex.unlock();
+            #endif
+        }
+        
+        void prepare(Waiter& waiter) {
+            #if defined(ESP32)
+            waiter.token = xTaskGetCurrentTaskHandle();
+            #else
+            waiter.token = 0;
+            #endif
+        }
+        
+        // Called and returns with the lock held. True once the waiter was granted.
+        bool wait(Waiter& waiter, uint32_t timeoutMs) {
+            #if defined(ESP32)
+            TickType_t start = xTaskGetTickCount();
+            TickType_t limit = (timeoutMs == MUXLIB_WAIT_FOREVER) ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs);
+            while (!waiter.granted) {
+                TickType_t waited = xTaskGetTickCount() - start;
+                if (limit != portMAX_DELAY && waited >= limit) break;
+                unlock();
+                ulTaskNotifyTake(pdTRUE, (limit == portMAX_DELAY) ? portMAX_DELAY : limit - waited);
+                lock();
+            }
+            return waiter.granted;
+            #elif defined(MUXLIB_HOST)
+            std::unique_lock<std::mutex> guard(mutex, std::adopt_lock);
+            if (timeoutMs == MUXLIB_WAIT_FOREVER) {
+                wakeup.wait(guard, [&waiter] { return (bool)waiter.granted; });
+            } else {
+                wakeup.wait_for(guard, std::chrono::milliseconds(timeoutMs),
+                                [&waiter] { return (bool)waiter.granted; });
+            }
+            guard.release();
+            return waiter.granted;
+            #else
+            return waiter.granted;
+            #endif
+        }
+        
+        // Called without the lock: granted waiters may return (and their
+        // Waiter go out of scope) as soon as the lock is dropped
+        void wake(const WakeToken* tokens, uint8_t count) {
+            #if defined(ESP32)
+            for (uint8_t i = 0; i < count; i++) {
+                xTaskNotifyGive(tokens[i]);
+            }
+            #elif defined(MUXLIB_HOST)
+            if (count) wakeup.notify_all();
+            #endif
+        }
+    };
+
+    class MUXArbiter;
+
+    // Ownership of a mux on one channel, returned by MUXArbiter::acquire().
+    // The mux stays on that channel until the lease is released or goes
+    // out of scope. Check it before use: a lease is only valid if the
+    // switch succeeded.
+    class MUXLease {
+    private:
+        MUXArbiter* arbiter;
+        uint8_t channel;
+        MUXStatus status;
+        
+    public:
+        MUXLease() : arbiter(nullptr), channel(255), status(MUXStatus::ERROR_INIT) {}
+        
+        MUXLease(MUXArbiter* owner, uint8_t ch, MUXStatus result)
+            : arbiter(owner), channel(ch), status(result) {}
+            
+        MUXLease(const MUXLease&) = delete;
+        MUXLease& operator=(const MUXLease&) = delete;
+        
+        MUXLease(MUXLease&& other)
+            : arbiter(other.arbiter), channel(other.channel), status(other.status) {
+            other.arbiter = nullptr;
+        }
+        
+        MUXLease& operator=(MUXLease&& other) {
+            if (this != &other) {
+                release();
+                arbiter = other.arbiter;
+                channel = other.channel;
+                status = other.status;
+                other.arbiter = nullptr;
+            }
+            return *this;
+        }
+        
+        ~MUXLease() {
+            release();
+        }
+        
+        bool valid() const { return arbiter != nullptr && status == MUXStatus::OK; }
+        explicit operator bool() const { return valid(); }
+        
+        uint8_t getChannel() const { return channel; }
+        MUXStatus getStatus() const { return status; }
+        
+        void release();
+    };
+
+    // Serializes switch-then-use access to one mux from several tasks.
+    // Holders of the current channel share it: a request for the channel
+    // that is already selected joins without switching, and when the mux
+    // frees up every waiter for the next channel is granted with a single
+    // switch. The next channel is the one requested by the waiter with
+    // the highest priority (first come first served among equals), and a
+    // new request cannot join the current channel while an equal or
+    // higher priority waiter needs another one.
+    class MUXArbiter {
+    private:
+        friend class MUXLease;
+        
+        MUXManager& mux;
+        LeaseLock guard;
+        LeaseLock::Waiter* waiters[MUXLIB_MAX_LEASE_WAITERS];
+        uint8_t waiterCount;
+        uint8_t activeChannel;      // 255 = not switched by the arbiter yet
+        uint8_t holders;
+        bool switching;
+        uint32_t switchCount;
+        uint32_t sharedCount;
+        
+        // Another channel is wanted by a waiter of at least this priority
+        bool contended(uint8_t priority) const {
+            for (uint8_t i = 0; i < waiterCount; i++) {
+                if (waiters[i]->priority >= priority) return true;
+            }
+            return false;
+        }
+        
+        void removeWaiter(uint8_t index) {
+            for (uint8_t i = index; i + 1 < waiterCount; i++) {
+                waiters[i] = waiters[i + 1];
+            }
+            waiterCount--;
+        }
+        
+        // Lock held on entry and exit; the switch itself runs unlocked
+        MUXStatus switchTo(uint8_t channel) {
+            if (activeChannel == channel && mux.getChannel() == channel) {
+                return MUXStatus::OK;
+            }
+            
+            switching = true;
+            guard.unlock();
+            MUXStatus status = mux.setChannel(channel);
+            guard.lock();
+            switching = false;
+            switchCount++;
+            activeChannel = (status == MUXStatus::OK) ? channel : 255;
+            return status;
+        }
+        
+        // Lock held: grant every waiter for this channel, collecting wake tokens
+        uint8_t grantWaiters(uint8_t channel, MUXStatus status, LeaseLock::WakeToken* tokens) {
+            uint8_t granted = 0;
+            for (uint8_t i = 0; i < waiterCount; ) {
+                LeaseLock::Waiter* waiter = waiters[i];
+                if (waiter->channel != channel) {
+                    i++;
+                    continue;
+                }
+                waiter->status = status;
+                waiter->granted = true;
+                tokens[granted++] = waiter->token;
+                holders++;
+                removeWaiter(i);
+            }
+            if (granted > 1) sharedCount += granted - 1;
+            return granted;
+        }
+        
+        // Lock held: index of the waiter that decides the next channel
+        uint8_t nextWaiter() const {
+            uint8_t best = 0;
+            for (uint8_t i = 1; i < waiterCount; i++) {
+                if (waiters[i]->priority > waiters[best]->priority) best = i;
+            }
+            return best;
+        }
+        
+        void release() {
+            LeaseLock::WakeToken tokens[MUXLIB_MAX_LEASE_WAITERS];
+            uint8_t woken = 0;
+            
+            guard.lock();
+            if (holders) holders--;
+            
+            // Hand the mux to the next channel; repeat if its waiters timed
+            // out while the switch was in progress
+            while (holders == 0 && waiterCount > 0 && woken == 0) {
+                uint8_t channel = waiters[nextWaiter()]->channel;
+                MUXStatus status = switchTo(channel);
+                woken = grantWaiters(channel, status, tokens);
+            }
+            guard.unlock();
+            guard.wake(tokens, woken);
+        }
+        
+    public:
+        MUXArbiter(MUXManager& device)
+            : mux(device), waiterCount(0), activeChannel(255), holders(0),
+              switching(false), switchCount(0), sharedCount(0) {}
+              
+        // Switch to a channel and hold it. Blocks (up to timeoutMs) while
+        // other tasks hold the mux on a different channel. Higher priority
+        // values are served first.
+        MUXLease acquire(uint8_t channel, uint8_t priority = 0,
+                         uint32_t timeoutMs = MUXLIB_WAIT_FOREVER) {
+            if (channel >= mux.getMaxChannels()) {
+                return MUXLease(nullptr, channel, MUXStatus::ERROR_CHANNEL_INVALID);
+            }
+            
+            guard.lock();
+            
+            // Already on this channel: share it
+            if (!switching && holders > 0 && activeChannel == channel && !contended(priority)) {
+                holders++;
+                sharedCount++;
+                guard.unlock();
+                return MUXLease(this, channel, MUXStatus::OK);
+            }
+            
+            // Idle: switch right away
+            if (!switching && holders == 0) {
+                LeaseLock::WakeToken tokens[MUXLIB_MAX_LEASE_WAITERS];
+                holders = 1;
+                MUXStatus status = switchTo(channel);
+                uint8_t woken = grantWaiters(channel, status, tokens);
+                guard.unlock();
+                guard.wake(tokens, woken);
+                return MUXLease(this, channel, status);
+            }
+            
+            if (waiterCount >= MUXLIB_MAX_LEASE_WAITERS) {
+                guard.unlock();
+                return MUXLease(nullptr, channel, MUXStatus::ERROR_OVERFLOW);
+            }
+            
+            LeaseLock::Waiter waiter;
+            waiter.channel = channel;
+            waiter.priority = priority;
+            waiter.granted = false;
+            waiter.status = MUXStatus::ERROR_TIMEOUT;
+            guard.prepare(waiter);
+            waiters[waiterCount++] = &waiter;
+            
+            bool granted = guard.wait(waiter, timeoutMs);
+            if (!granted) {
+                for (uint8_t i = 0; i < waiterCount; i++) {
+                    if (waiters[i] == &waiter) {
+                        removeWaiter(i);
+                        break;
+                    }
+                }
+            }
+            guard.unlock();
+            
+            if (!granted) return MUXLease(nullptr, channel, MUXStatus::ERROR_TIMEOUT);
+            return MUXLease(this, channel, waiter.status);
+        }
+        
+        // Non-blocking acquire
+        MUXLease tryAcquire(uint8_t channel, uint8_t priority = 0) {
+            return acquire(channel, priority, 0);
+        }
+        
+        MUXManager& getMux() { return mux; }
+        
+        // Channel switches performed, and grants that reused a switch
+        uint32_t getSwitchCount() const { return switchCount; }
+        uint32_t getSharedCount() const { return sharedCount; }
+    };
+
+    inline void MUXLease::release() {
+        if (arbiter) {
+            MUXArbiter* owner = arbiter;
+            arbiter = nullptr;
+            owner->release();
+        }
+    }
+}
+
+#endif
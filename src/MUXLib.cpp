@@ -2,120 +2,227 @@
 #include "MUXLib.h"
 
 namespace MUXLib {
-    MUXManager::MUXManager(uint8_t address, uint8_t channels) 
-        : deviceAddress(address)
-        , enabled(false)
-        , currentChannel(0)
-        , maxChannels(channels)
-        , interruptHandler(nullptr)
-        , interruptFlag(false)
-        , interruptPin(255) {
-    }
+    #if MUXLIB_MAX_INTERRUPTS > 8
+        #error "MUXLIB_MAX_INTERRUPTS supports at most 8 interrupt owners"
+    #endif
 
-    MUXManager::~MUXManager() {
-        if (interruptPin != 255) {
-            detachInterrupt();
-        }
-    }
+    MUXManager* volatile MUXManager::interruptOwners[MUXLIB_MAX_INTERRUPTS] = { nullptr };
+    MUXManager::InterruptEvent MUXManager::eventQueue[MUXLIB_INTERRUPT_QUEUE_SIZE];
+    volatile uint8_t MUXManager::eventHead = 0;
+    volatile uint8_t MUXManager::eventTail = 0;
+    volatile uint8_t MUXManager::eventsDropped = 0;
 
-    uint8_t MUXManager::getChannel() {
-        return currentChannel;
+    // One plain function per dispatch slot, since ::attachInterrupt cannot
+    // take a capturing lambda or a member function
+    template <uint8_t Slot>
+    void MUXLIB_ISR_ATTR MUXManager::isrTrampoline() {
+        dispatchInterrupt(Slot);
     }
 
-    bool MUXManager::isEnabled() {
-        return enabled;
+    void (* const MUXManager::isrTable[MUXLIB_MAX_INTERRUPTS])() = {
+        isrTrampoline<0>,
+        #if MUXLIB_MAX_INTERRUPTS > 1
+        isrTrampoline<1>,
+        #endif
+        #if MUXLIB_MAX_INTERRUPTS > 2
+        isrTrampoline<2>,
+        #endif
+        #if MUXLIB_MAX_INTERRUPTS > 3
+        isrTrampoline<3>,
+        #endif
+        #if MUXLIB_MAX_INTERRUPTS > 4
+        isrTrampoline<4>,
+        #endif
+        #if MUXLIB_MAX_INTERRUPTS > 5
+        isrTrampoline<5>,
+        #endif
+        #if MUXLIB_MAX_INTERRUPTS > 6
+        isrTrampoline<6>,
+        #endif
+        #if MUXLIB_MAX_INTERRUPTS > 7
+        isrTrampoline<7>,
+        #endif
+    };
+
+    // ISR context: flag the owner, run its ISR hook and queue the event.
+    // Owners without a callback only poll their flag, so nothing is queued
+    // for them and they cannot fill the queue shared by every instance.
+    void MUXLIB_ISR_ATTR MUXManager::dispatchInterrupt(uint8_t slot) {
+        MUXManager* owner = interruptOwners[slot];
+        if (!owner) return;
+        
+        owner->interruptFlag = true;
+        if (owner->onInterruptISR() || !owner->interruptHandler) return;
+        
+        uint8_t next = (eventHead + 1) % MUXLIB_INTERRUPT_QUEUE_SIZE;
+        if (next == eventTail) {
+            if (eventsDropped < 255) eventsDropped++;
+            return;
+        }
+        eventQueue[eventHead].slot = slot;
+        eventQueue[eventHead].channel = owner->currentChannel;
+        eventHead = next;
     }
 
-    void MUXManager::enable() {
-        enabled = true;
+    static bool interruptModeSupported(InterruptMode mode) {
+        if (mode == InterruptMode::NONE) return false;
+        #if defined(MUXLIB_LINUX)
+        // GPIO character devices only report edges
+        if (mode == InterruptMode::LOW_LEVEL || mode == InterruptMode::HIGH_LEVEL) return false;
+        #endif
+        return true;
     }
 
-    void MUXManager::disable() {
-        enabled = false;
+    static uint8_t arduinoInterruptMode(InterruptMode mode) {
+        switch (mode) {
+            case InterruptMode::LOW_LEVEL:
+                return LOW;
+            case InterruptMode::HIGH_LEVEL:
+                return HIGH;
+            case InterruptMode::FALLING_EDGE:
+                return FALLING;
+            case InterruptMode::RISING_EDGE:
+                return RISING;
+            case InterruptMode::BOTH_EDGES:
+            default:
+                return CHANGE;
+        }
     }
 
-    void MUXManager::attachInterrupt(InterruptCallback callback, uint8_t pin, InterruptMode mode) {
-        interruptHandler = callback;
-        interruptPin = pin;
+    MUXStatus MUXManager::attachInterrupt(InterruptCallback callback, uint8_t pin, InterruptMode mode) {
+        if (pin == 255 || !interruptModeSupported(mode)) return MUXStatus::ERROR_INIT;
         
-        if (pin != 255) {
-            pinMode(pin, INPUT_PULLUP);
-            uint8_t arduinoMode;
-            
-            switch (mode) {
-                case InterruptMode::LOW_LEVEL:
-                    arduinoMode = LOW;
-                    break;
-                case InterruptMode::HIGH_LEVEL:
-                    arduinoMode = HIGH;
-                    break;
-                case InterruptMode::FALLING_EDGE:
-                    arduinoMode = FALLING;
-                    break;
-                case InterruptMode::RISING_EDGE:
-                    arduinoMode = RISING;
-                    break;
-                case InterruptMode::CHANGE:
-                default:
-                    arduinoMode = CHANGE;
-                    break;
+        if (interruptSlot != 255) {
+            detachInterrupt();
+        }
+        
+        uint8_t slot = 255;
+        for (uint8_t i = 0; i < MUXLIB_MAX_INTERRUPTS; i++) {
+            if (!interruptOwners[i]) {
+                slot = i;
+                break;
             }
-
-            // Store this pointer for ISR
-            static MUXManager* instance = this;
-            
-            ::attachInterrupt(digitalPinToInterrupt(pin), 
-                            []() {
-                                // Static ISR wrapper
-                                if (instance && instance->interruptHandler) {
-                                    instance->interruptHandler(instance->currentChannel);
-                                }
-                                instance->interruptFlag = true;
-                            }, 
-                            arduinoMode);
         }
+        if (slot == 255) return MUXStatus::ERROR_OVERFLOW;
+        
+        interruptHandler = callback;
+        interruptPin = pin;
+        interruptSlot = slot;
+        interruptFlag = false;
+        interruptOwners[slot] = this;
+        
+        pinMode(pin, INPUT_PULLUP);
+        ::attachInterrupt(digitalPinToInterrupt(pin), isrTable[slot], arduinoInterruptMode(mode));
+        return MUXStatus::OK;
     }
 
     void MUXManager::detachInterrupt() {
         if (interruptPin != 255) {
             ::detachInterrupt(digitalPinToInterrupt(interruptPin));
-            interruptHandler = nullptr;
-            interruptPin = 255;
-            interruptFlag = false;
         }
+        
+        if (interruptSlot != 255) {
+            noInterrupts();
+            interruptOwners[interruptSlot] = nullptr;
+            // Drop events still queued for this instance
+            for (uint8_t i = eventTail; i != eventHead; i = (i + 1) % MUXLIB_INTERRUPT_QUEUE_SIZE) {
+                if (eventQueue[i].slot == interruptSlot) {
+                    eventQueue[i].slot = 255;
+                }
+            }
+            interrupts();
+        }
+        
+        interruptHandler = nullptr;
+        interruptPin = 255;
+        interruptSlot = 255;
+        interruptFlag = false;
     }
 
-    bool MUXManager::startScan(uint8_t startChannel, uint8_t endChannel) {
-        return false;
-    }
-
-    void MUXManager::stopScan() {
-    }
-
-    void MUXManager::sleep() {
+    uint8_t MUXManager::processInterrupts() {
+        uint8_t handled = 0;
+        
+        while (true) {
+            noInterrupts();
+            if (eventTail == eventHead) {
+                interrupts();
+                break;
+            }
+            InterruptEvent event = eventQueue[eventTail];
+            eventTail = (eventTail + 1) % MUXLIB_INTERRUPT_QUEUE_SIZE;
+            MUXManager* owner = (event.slot != 255) ? interruptOwners[event.slot] : nullptr;
+            interrupts();
+            
+            if (owner && owner->interruptHandler) {
+                owner->interruptHandler(event.channel);
+                handled++;
+            }
+        }
+        
+        return handled;
     }
 
-    void MUXManager::wake() {
-    }
+    // Flag-only interrupt slots (CompactMUX interrupt policy), a separate
+    // pool of MUXLIB_MAX_INTERRUPTS from the MUXManager dispatch table
+    static volatile bool* volatile flagOwners[MUXLIB_MAX_INTERRUPTS] = { nullptr };
 
-    bool MUXManager::selfTest() {
-        return true;
+    template <uint8_t Slot>
+    static void MUXLIB_ISR_ATTR flagTrampoline() {
+        volatile bool* flag = flagOwners[Slot];
+        if (flag) *flag = true;
     }
 
-    uint16_t MUXManager::readDiagnostics() {
-        return 0;
-    }
+    static void (* const flagTable[MUXLIB_MAX_INTERRUPTS])() = {
+        flagTrampoline<0>,
+        #if MUXLIB_MAX_INTERRUPTS > 1
+        flagTrampoline<1>,
+        #endif
+        #if MUXLIB_MAX_INTERRUPTS > 2
+        flagTrampoline<2>,
+        #endif
+        #if MUXLIB_MAX_INTERRUPTS > 3
+        flagTrampoline<3>,
+        #endif
+        #if MUXLIB_MAX_INTERRUPTS > 4
+        flagTrampoline<4>,
+        #endif
+        #if MUXLIB_MAX_INTERRUPTS > 5
+        flagTrampoline<5>,
+        #endif
+        #if MUXLIB_MAX_INTERRUPTS > 6
+        flagTrampoline<6>,
+        #endif
+        #if MUXLIB_MAX_INTERRUPTS > 7
+        flagTrampoline<7>,
+        #endif
+    };
 
-    bool MUXManager::isValidChannel(uint8_t channel) const {
-        return channel < maxChannels;
+    MUXStatus attachFlagInterrupt(volatile bool* flag, uint8_t pin, InterruptMode mode, uint8_t& slot) {
+        if (!flag || pin == 255 || !interruptModeSupported(mode)) return MUXStatus::ERROR_INIT;
+        
+        slot = 255;
+        for (uint8_t i = 0; i < MUXLIB_MAX_INTERRUPTS; i++) {
+            if (!flagOwners[i]) {
+                slot = i;
+                break;
+            }
+        }
+        if (slot == 255) return MUXStatus::ERROR_OVERFLOW;
+        
+        *flag = false;
+        flagOwners[slot] = flag;
+        pinMode(pin, INPUT_PULLUP);
+        ::attachInterrupt(digitalPinToInterrupt(pin), flagTable[slot], arduinoInterruptMode(mode));
+        return MUXStatus::OK;
     }
 
-    void MUXManager::delayMicros(unsigned int us) {
-        #if defined(ESP8266) || defined(ESP32)
-            ets_delay_us(us);
-        #else
-            delayMicroseconds(us);
-        #endif
+    void detachFlagInterrupt(uint8_t pin, uint8_t slot) {
+        if (pin != 255) {
+            ::detachInterrupt(digitalPinToInterrupt(pin));
+        }
+        if (slot < MUXLIB_MAX_INTERRUPTS) {
+            flagOwners[slot] = nullptr;
+        }
     }
 
     // Optional: Static helper functions that might be useful across different MUX types
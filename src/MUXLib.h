@@ -0,0 +1,502 @@
+// Core MUX Library Header (MUXLib.h)
+// (C) Chirs Formeister 2024. All Rights Reserved
+
+#ifndef MUXLIB_H
+#define MUXLIB_H
+
+#include <Arduino.h>
+#include "MUXLibConfig.h"
+
+// Number of MUX instances that can own an interrupt pin at once (max 8)
+#ifndef MUXLIB_MAX_INTERRUPTS
+    #define MUXLIB_MAX_INTERRUPTS 4
+#endif
+
+// Deferred interrupt events buffered between processInterrupts() calls
+#ifndef MUXLIB_INTERRUPT_QUEUE_SIZE
+    #define MUXLIB_INTERRUPT_QUEUE_SIZE 8
+#endif
+
+// ISR code must live in IRAM on the ESP parts
+#if defined(ESP8266) || defined(ESP32)
+    #define MUXLIB_ISR_ATTR IRAM_ATTR
+#else
+    #define MUXLIB_ISR_ATTR
+#endif
+
+namespace MUXLib {
+    enum class MUXStatus {
+        OK,
+        ERROR_INIT,
+        ERROR_COMMUNICATION,
+        ERROR_CHANNEL_INVALID,
+        ERROR_NOT_ENABLED,
+        ERROR_OVERFLOW,
+        ERROR_TIMEOUT
+    };
+
+    enum class InterruptMode {
+        NONE,
+        LOW_LEVEL,
+        HIGH_LEVEL,
+        FALLING_EDGE,
+        RISING_EDGE,
+        BOTH_EDGES   // Arduino's CHANGE (that name is a macro in Arduino.h)
+    };
+
+    // Platform-independent interrupt handling
+    typedef void (*InterruptCallback)(uint8_t);
+
+    // Outcome of runSelfTest(): one bit per channel (or pattern) tested
+    struct SelfTestResult {
+        uint32_t passMask;
+        uint32_t failMask;
+        uint16_t settleMicros;      // Worst measured settling time (analog muxes)
+        uint32_t durationMicros;    // Time taken by the whole test
+    };
+
+    // Snapshot of the instrumentation counters of one MUX instance
+    struct MUXDiagnostics {
+        uint32_t switchCount;           // setChannel() calls that reached the hardware
+        uint32_t redundantSwitches;     // ... of which re-selected the current channel
+        uint16_t busErrors;             // I2C/SPI transfers that failed
+        uint16_t overflows;             // ERROR_OVERFLOW returns
+        uint32_t settleMicros;          // Total time spent waiting for settling
+        uint16_t setChannelHistogram[MUXLIB_DIAG_BUCKETS];
+        uint16_t readChannelHistogram[MUXLIB_DIAG_BUCKETS];
+    };
+
+    #if MUXLIB_ENABLE_DIAGNOSTICS
+        // Adds the lifetime of a scope to a log2 latency histogram
+        class DiagScope {
+        private:
+            uint16_t* histogram;
+            uint32_t start;
+            
+        public:
+            DiagScope(uint16_t* hist) : histogram(hist), start(micros()) {}
+            
+            ~DiagScope() {
+                uint32_t elapsed = micros() - start;
+                uint8_t bucket = 0;
+                while (elapsed > 1 && bucket < MUXLIB_DIAG_BUCKETS - 1) {
+                    elapsed >>= 1;
+                    bucket++;
+                }
+                if (histogram[bucket] < 0xFFFF) histogram[bucket]++;
+            }
+        };
+        
+        #define MUXLIB_DIAG(statement) statement
+        #define MUXLIB_DIAG_SCOPE(histogram) DiagScope diagScope_(diagnostics.histogram)
+    #else
+        #define MUXLIB_DIAG(statement)
+        #define MUXLIB_DIAG_SCOPE(histogram)
+    #endif
+
+    enum class TraceOp : uint8_t {
+        GAP,        // Time extension, value = bits 16-31 of the delta
+        SWITCH,     // setChannel() finished, value = microseconds taken
+        SAMPLE,     // Channel read, value = sample
+        SETTLE,     // Settling wait, value = microseconds
+        I2C,        // Bus transfer, channel = address (bit 7 set for reads),
+                    // status = Wire result, value = microseconds taken
+        MARK        // MUXTrace::mark() from the application
+    };
+
+    // One trace record. dump() writes the fields little-endian.
+    struct TraceEvent {
+        uint16_t delta;     // Microseconds since the previous event
+        uint8_t instance;   // Trace id of the MUX, 255 = application
+        uint8_t op;
+        uint8_t channel;
+        uint8_t status;
+        uint16_t value;
+    };
+
+    #if MUXLIB_ENABLE_TRACE
+        // Ring of the most recent events of every MUX instance. Record from
+        // the main loop or a task, not from interrupt handlers.
+        class MUXTrace {
+        private:
+            struct Ring {
+                TraceEvent events[MUXLIB_TRACE_EVENTS];
+                uint16_t head;          // Next slot to write
+                uint16_t count;
+                uint32_t overwritten;
+                uint32_t lastMicros;    // Time of the newest event
+                uint8_t nextId;
+                bool started;
+                bool paused;
+            };
+            
+            static Ring& ring() {
+                static Ring r;
+                return r;
+            }
+            
+            static void push(uint16_t delta, uint8_t instance, TraceOp op, uint8_t channel,
+                             uint8_t status, uint16_t value) {
+                Ring& r = ring();
+                TraceEvent& e = r.events[r.head];
+                e.delta = delta;
+                e.instance = instance;
+                e.op = (uint8_t)op;
+                e.channel = channel;
+                e.status = status;
+                e.value = value;
+                
+                r.head = (r.head + 1) % MUXLIB_TRACE_EVENTS;
+                if (r.count < MUXLIB_TRACE_EVENTS) {
+                    r.count++;
+                } else {
+                    r.overwritten++;
+                }
+            }
+            
+            template <typename Port>
+            static void writeLE(Port& port, uint32_t value, uint8_t bytes) {
+                for (uint8_t i = 0; i < bytes; i++) {
+                    port.write((uint8_t)(value >> (8 * i)));
+                }
+            }
+            
+            // Same bytes as dump(), as hex text lines for a serial monitor
+            template <typename Port>
+            struct HexPort {
+                Port& port;
+                uint8_t column;
+                
+                void write(uint8_t value) {
+                    const char* digits = "0123456789ABCDEF";
+                    port.write((uint8_t)digits[value >> 4]);
+                    port.write((uint8_t)digits[value & 0x0F]);
+                    if (++column == 32) {
+                        port.write((uint8_t)'\n');
+                        column = 0;
+                    }
+                }
+            };
+            
+            template <typename Port>
+            static void writeTrace(Port& port) {
+                Ring& r = ring();
+                port.write((uint8_t)'M');
+                port.write((uint8_t)'X');
+                port.write((uint8_t)'T');
+                port.write((uint8_t)'R');
+                writeLE(port, 1, 1);                    // Format version
+                writeLE(port, sizeof(TraceEvent), 1);
+                writeLE(port, r.count, 2);
+                writeLE(port, r.overwritten, 4);
+                writeLE(port, r.lastMicros, 4);
+                
+                uint16_t index = (r.head + MUXLIB_TRACE_EVENTS - r.count) % MUXLIB_TRACE_EVENTS;
+                for (uint16_t i = 0; i < r.count; i++) {
+                    const TraceEvent& e = r.events[index];
+                    writeLE(port, e.delta, 2);
+                    writeLE(port, e.instance, 1);
+                    writeLE(port, e.op, 1);
+                    writeLE(port, e.channel, 1);
+                    writeLE(port, e.status, 1);
+                    writeLE(port, e.value, 2);
+                    index = (index + 1) % MUXLIB_TRACE_EVENTS;
+                }
+            }
+            
+        public:
+            static uint8_t assignId() {
+                uint8_t id = ring().nextId++;
+                if (ring().nextId == 255) ring().nextId = 0;
+                return id;
+            }
+            
+            static void record(uint8_t instance, TraceOp op, uint8_t channel,
+                               uint8_t status, uint32_t value) {
+                Ring& r = ring();
+                if (r.paused) return;
+                
+                noInterrupts();
+                uint32_t now = micros();
+                uint32_t delta = r.started ? now - r.lastMicros : 0;
+                r.lastMicros = now;
+                r.started = true;
+                if (delta > 0xFFFF) {
+                    uint32_t high = delta >> 16;
+                    push(delta & 0xFFFF, 255, TraceOp::GAP, 0, 0, high > 0xFFFF ? 0xFFFF : high);
+                    delta = 0;
+                }
+                push(delta, instance, op, channel, status, value > 0xFFFF ? 0xFFFF : value);
+                interrupts();
+            }
+            
+            // Application marker, e.g. to tag the start of a measurement cycle
+            static void mark(uint8_t tag, uint16_t value = 0) {
+                record(255, TraceOp::MARK, tag, 0, value);
+            }
+            
+            static void clear() {
+                noInterrupts();
+                ring().head = 0;
+                ring().count = 0;
+                ring().overwritten = 0;
+                ring().started = false;
+                interrupts();
+            }
+            
+            // Stop recording, e.g. right after a fault so the lead-up is kept
+            static void pause(bool paused = true) { ring().paused = paused; }
+            
+            // Write the ring as binary for extras/tools/muxtrace.py. Pause
+            // (or stop calling the library) while dumping.
+            template <typename Port>
+            static void dump(Port& port) {
+                writeTrace(port);
+            }
+            
+            // Hex text version of dump(), for copying out of a serial monitor
+            template <typename Port>
+            static void dumpHex(Port& port) {
+                HexPort<Port> hex = { port, 0 };
+                port.write((const uint8_t*)"#MXTR-BEGIN\n", 12);
+                writeTrace(hex);
+                if (hex.column) port.write((uint8_t)'\n');
+                port.write((const uint8_t*)"#MXTR-END\n", 10);
+            }
+            
+            static uint16_t size() { return ring().count; }
+            static uint32_t overwritten() { return ring().overwritten; }
+        };
+        
+        // Records a SWITCH event with the lifetime of a scope. Failures
+        // returned through result() are recorded with their status.
+        class TraceScope {
+        private:
+            uint8_t instance;
+            uint8_t channel;
+            uint8_t status;
+            uint32_t start;
+            
+        public:
+            TraceScope(uint8_t id, uint8_t ch) : instance(id), channel(ch), status(0), start(micros()) {}
+            
+            ~TraceScope() {
+                MUXTrace::record(instance, TraceOp::SWITCH, channel, status, micros() - start);
+            }
+            
+            MUXStatus result(MUXStatus value) {
+                status = (uint8_t)value;
+                return value;
+            }
+        };
+        
+        #define MUXLIB_TRACE(statement) statement
+        #define MUXLIB_TRACE_SCOPE(channel) TraceScope traceScope_(traceId, channel)
+        #define MUXLIB_TRACE_RESULT(status) traceScope_.result(status)
+    #else
+        #define MUXLIB_TRACE(statement)
+        #define MUXLIB_TRACE_SCOPE(channel)
+        #define MUXLIB_TRACE_RESULT(status) (status)
+    #endif
+
+    class MUXManager {
+    protected:
+        uint8_t deviceAddress;
+        bool enabled;
+        bool sleeping;
+        uint8_t currentChannel;
+        uint8_t maxChannels;
+        InterruptCallback interruptHandler;
+        volatile bool interruptFlag;
+        uint8_t interruptPin;
+        uint8_t interruptSlot;  // Index into the ISR dispatch table, 255 = none
+        
+    public:
+        MUXManager(uint8_t address, uint8_t channels) 
+            : deviceAddress(address), enabled(false), sleeping(false), currentChannel(0),
+              maxChannels(channels), interruptHandler(nullptr), 
+              interruptFlag(false), interruptPin(255), interruptSlot(255) {
+            resetDiagnostics();
+            MUXLIB_TRACE(traceId = MUXTrace::assignId());
+        }
+              
+        virtual ~MUXManager() {
+            if (interruptPin != 255) {
+                detachInterrupt();
+            }
+        }
+        
+        virtual MUXStatus begin() = 0;
+        virtual MUXStatus setChannel(uint8_t channel) = 0;
+        virtual uint8_t getChannel() { return currentChannel; }
+        uint8_t getMaxChannels() const { return maxChannels; }
+        
+        virtual bool isEnabled() { return enabled; }
+        virtual void enable() { enabled = true; }
+        virtual void disable() { enabled = false; }
+        
+        // Platform-independent interrupt handling.
+        // The ISR only sets this instance's flag and queues an event; the
+        // callback runs later from processInterrupts() in the main loop.
+        virtual MUXStatus attachInterrupt(InterruptCallback callback, uint8_t pin,
+                                          InterruptMode mode = InterruptMode::BOTH_EDGES);
+        virtual void detachInterrupt();
+        
+        // Returns true (once) if an interrupt arrived since the last call
+        bool interruptPending() {
+            bool pending = interruptFlag;
+            interruptFlag = false;
+            return pending;
+        }
+        
+        // Run the callbacks of all queued interrupt events, call from loop().
+        // Returns the number of events handled.
+        static uint8_t processInterrupts();
+        
+        // Events lost because the deferred queue was full
+        static uint8_t droppedInterrupts() { return eventsDropped; }
+        
+        // Channel scanning
+        virtual bool startScan(uint8_t startChannel = 0, uint8_t endChannel = 0) { 
+            return false; 
+        }
+        virtual void stopScan() {}
+        
+        // Power management. sleep() parks the device in its lowest-leakage
+        // state and remembers the selected channel; wake() restores it.
+        virtual void sleep() {}
+        virtual void wake() {}
+        bool isSleeping() const { return sleeping; }
+        
+        // Simple diagnostics
+        virtual bool selfTest() {
+            SelfTestResult result;
+            return runSelfTest(result);
+        }
+        
+        // Device specific self-test with per-channel results and timings.
+        // Devices without a meaningful check pass with an empty mask.
+        virtual bool runSelfTest(SelfTestResult& result) {
+            memset(&result, 0, sizeof(result));
+            return true;
+        }
+        
+        // Bus errors plus overflows since the last reset (0 without instrumentation)
+        virtual uint16_t readDiagnostics() {
+            #if MUXLIB_ENABLE_DIAGNOSTICS
+                uint32_t errors = (uint32_t)diagnostics.busErrors + diagnostics.overflows;
+                return errors > 0xFFFF ? 0xFFFF : errors;
+            #else
+                return 0;
+            #endif
+        }
+        
+        // Copy the instrumentation counters; false if compiled out
+        bool getDiagnostics(MUXDiagnostics& snapshot) const {
+            #if MUXLIB_ENABLE_DIAGNOSTICS
+                snapshot = diagnostics;
+                return true;
+            #else
+                memset(&snapshot, 0, sizeof(snapshot));
+                return false;
+            #endif
+        }
+        
+        void resetDiagnostics() {
+            #if MUXLIB_ENABLE_DIAGNOSTICS
+                memset(&diagnostics, 0, sizeof(diagnostics));
+            #endif
+        }
+        
+        #if MUXLIB_ENABLE_TRACE
+            // Instance field of this MUX's trace events (assigned in order of construction)
+            uint8_t getTraceId() const { return traceId; }
+            void setTraceId(uint8_t id) { traceId = id; }
+        #endif
+        
+    protected:
+        // Utility function for bounds checking
+        bool isValidChannel(uint8_t channel) const {
+            return channel < maxChannels;
+        }
+        
+        // Platform-independent delay microseconds
+        void delayMicros(unsigned int us) {
+            #if defined(ESP8266) || defined(ESP32)
+                ets_delay_us(us);
+            #else
+                delayMicroseconds(us);
+            #endif
+        }
+        
+        // Runs inside the ISR of an attached interrupt, before the event is
+        // queued. Keep it short; return true to consume the event so no
+        // callback is queued for it.
+        virtual bool MUXLIB_ISR_ATTR onInterruptISR() { return false; }
+        
+        // Wait for an analog signal to settle (counted by the instrumentation)
+        void settle(unsigned int us) {
+            delayMicros(us);
+            MUXLIB_DIAG(diagnostics.settleMicros += us);
+            MUXLIB_TRACE(trace(TraceOp::SETTLE, currentChannel, 0, us));
+        }
+        
+        #if MUXLIB_ENABLE_DIAGNOSTICS
+            MUXDiagnostics diagnostics;  // Only if enabled in MUXLibConfig.h
+            
+            void diagSwitch(uint8_t channel) {
+                if (diagnostics.switchCount && channel == currentChannel) {
+                    diagnostics.redundantSwitches++;
+                }
+                diagnostics.switchCount++;
+            }
+            
+            void diagBusError() {
+                if (diagnostics.busErrors < 0xFFFF) diagnostics.busErrors++;
+            }
+            
+            void diagOverflow() {
+                if (diagnostics.overflows < 0xFFFF) diagnostics.overflows++;
+            }
+        #endif
+        
+        #if MUXLIB_ENABLE_TRACE
+            uint8_t traceId;  // Only if enabled in MUXLibConfig.h
+            
+            void trace(TraceOp op, uint8_t channel, uint8_t status, uint32_t value) {
+                MUXTrace::record(traceId, op, channel, status, value);
+            }
+        #endif
+        
+    private:
+        struct InterruptEvent {
+            uint8_t slot;
+            uint8_t channel;
+        };
+        
+        static MUXManager* volatile interruptOwners[MUXLIB_MAX_INTERRUPTS];
+        static InterruptEvent eventQueue[MUXLIB_INTERRUPT_QUEUE_SIZE];
+        static volatile uint8_t eventHead;
+        static volatile uint8_t eventTail;
+        static volatile uint8_t eventsDropped;
+        
+        static void dispatchInterrupt(uint8_t slot);
+        template <uint8_t Slot> static void isrTrampoline();
+        static void (* const isrTable[MUXLIB_MAX_INTERRUPTS])();
+    };
+
+    // Interrupt slots that only set a flag, for muxes without a MUXManager
+    // base (CompactMUX.h). The slot is returned for detachFlagInterrupt().
+    MUXStatus attachFlagInterrupt(volatile bool* flag, uint8_t pin, InterruptMode mode, uint8_t& slot);
+    void detachFlagInterrupt(uint8_t pin, uint8_t slot);
+
+    // Helpers shared across MUX types (MUXLib.cpp)
+    namespace Utility {
+        uint8_t reverseBits(uint8_t b);
+        uint16_t calculateCRC(uint8_t* data, uint8_t length);  // CRC-16/MODBUS
+        bool isChannelInRange(uint8_t channel, uint8_t maxChannels);
+        uint8_t calculateRequiredSelectPins(uint8_t channels);
+    }
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,33 @@
+// Library-wide build settings (MUXLibConfig.h)
+//
+// These change the layout of MUXManager, so every translation unit,
+// including the library's own MUXLib.cpp, must see the same values. Edit
+// them here, or pass them to the whole build as compiler flags (e.g.
+// build_flags = -DMUXLIB_ENABLE_DIAGNOSTICS=1 in PlatformIO). A #define
+// in the sketch only reaches the sketch and breaks the build.
+#ifndef MUXLIBCONFIG_H
+#define MUXLIBCONFIG_H
+
+// Hot-path instrumentation (switch/error counters, latency histograms)
+#ifndef MUXLIB_ENABLE_DIAGNOSTICS
+    #define MUXLIB_ENABLE_DIAGNOSTICS 0
+#endif
+
+// Number of log2 latency buckets: bucket n counts calls taking
+// [2^n, 2^(n+1)) microseconds, the last bucket is open-ended
+#ifndef MUXLIB_DIAG_BUCKETS
+    #define MUXLIB_DIAG_BUCKETS 12
+#endif
+
+// Binary trace of switches, samples, settling waits and I2C transfers,
+// recorded into a RAM ring and dumped with MUXTrace::dump()
+#ifndef MUXLIB_ENABLE_TRACE
+    #define MUXLIB_ENABLE_TRACE 0
+#endif
+
+// Trace ring capacity in events (8 bytes each)
+#ifndef MUXLIB_TRACE_EVENTS
+    #define MUXLIB_TRACE_EVENTS 128
+#endif
+
+#endif
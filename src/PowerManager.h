@@ -0,0 +1,72 @@
+// Aggregate Power Management (PowerManager.h)
+#ifndef POWERMANAGER_H
+#define POWERMANAGER_H
+
+#include "MUXLib.h"
+
+#ifndef MUXLIB_MAX_POWER_DEVICES
+    #define MUXLIB_MAX_POWER_DEVICES 8
+#endif
+
+namespace MUXLib {
+    // Puts every registered MUX to sleep before the MCU sleeps and
+    // restores them afterwards. Devices are woken in registration order
+    // and put to sleep in reverse, so register upstream muxes (e.g. the
+    // root of a cascaded I2C tree) first.
+    class PowerManager {
+    private:
+        MUXManager* devices[MUXLIB_MAX_POWER_DEVICES];
+        uint8_t deviceCount;
+        bool sleeping;
+        uint32_t wakeMicros;    // Duration of the last wakeAll()
+        
+    public:
+        PowerManager() : deviceCount(0), sleeping(false), wakeMicros(0) {}
+        
+        MUXStatus add(MUXManager& mux) {
+            for (uint8_t i = 0; i < deviceCount; i++) {
+                if (devices[i] == &mux) return MUXStatus::OK;
+            }
+            if (deviceCount >= MUXLIB_MAX_POWER_DEVICES) return MUXStatus::ERROR_OVERFLOW;
+            
+            devices[deviceCount++] = &mux;
+            return MUXStatus::OK;
+        }
+        
+        void remove(MUXManager& mux) {
+            for (uint8_t i = 0; i < deviceCount; i++) {
+                if (devices[i] == &mux) {
+                    for (uint8_t j = i; j + 1 < deviceCount; j++) {
+                        devices[j] = devices[j + 1];
+                    }
+                    deviceCount--;
+                    return;
+                }
+            }
+        }
+        
+        void sleepAll() {
+            for (uint8_t i = deviceCount; i > 0; i--) {
+                devices[i - 1]->sleep();
+            }
+            sleeping = true;
+        }
+        
+        void wakeAll() {
+            uint32_t start = micros();
+            for (uint8_t i = 0; i < deviceCount; i++) {
+                devices[i]->wake();
+            }
+            wakeMicros = micros() - start;
+            sleeping = false;
+        }
+        
+        bool isSleeping() const { return sleeping; }
+        uint8_t getDeviceCount() const { return deviceCount; }
+        
+        // Time spent restoring all devices in the last wakeAll()
+        uint32_t getLastWakeMicros() const { return wakeMicros; }
+    };
+}
+
+#endif
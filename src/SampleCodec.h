@@ -0,0 +1,360 @@
+// Compact Sample Encoding (SampleCodec.h)
+#ifndef SAMPLECODEC_H
+#define SAMPLECODEC_H
+
+#include "MUXLib.h"
+
+namespace MUXLib {
+    // Framed binary export of sweep results. A frame holds one or more
+    // sweeps of the same consecutive channels. Each value is the difference
+    // from the channel's previous value, zig-zag mapped, then either varint
+    // coded or packed at the smallest bit width that holds the whole sweep.
+    // The first sweep of a keyframe holds differences from zero, so a
+    // receiver can start or recover after a lost frame.
+    //
+    //   0       0xA5 sync
+    //   1       flags: bit 7 keyframe
+    //   2       sequence number
+    //   3       first channel
+    //   4       channel count
+    //   5       sweeps
+    //   6       payload length
+    //   7..     payload, per sweep: 0x80 then varints, or bit width 0-16
+    //           then the values packed LSB first
+    //   last 2  CRC-16 of all bytes before it (Utility::calculateCRC), LSB first
+    enum class SampleEncoding : uint8_t {
+        AUTO,           // Whichever is smaller, decided per sweep
+        VARINT,
+        PACKED
+    };
+
+    namespace SampleFrame {
+        const uint8_t SYNC = 0xA5;
+        const uint8_t HEADER = 7;
+        const uint8_t OVERHEAD = HEADER + 2;
+        const uint8_t KEYFRAME = 0x80;
+        const uint8_t VARINT_SWEEP = 0x80;
+        
+        inline uint16_t zigzag(int16_t delta) {
+            return (uint16_t)((uint16_t)delta << 1) ^ (uint16_t)(delta >> 15);
+        }
+        
+        inline int16_t unzigzag(uint16_t value) {
+            return (int16_t)((value >> 1) ^ (uint16_t)(0 - (value & 1)));
+        }
+        
+        inline uint8_t varintSize(uint16_t value) {
+            return value < 0x80 ? 1 : (value < 0x4000 ? 2 : 3);
+        }
+        
+        inline uint8_t bitWidth(uint16_t value) {
+            uint8_t width = 0;
+            while (value) {
+                width++;
+                value >>= 1;
+            }
+            return width;
+        }
+    }
+
+    // Builds frames from sweeps. The per-channel state and the frame buffer
+    // belong to the caller, so nothing is allocated. The buffer limits the
+    // frame size (at most 255 bytes).
+    class SampleEncoder {
+    private:
+        uint16_t* previous;         // Last encoded value per channel
+        uint8_t numChannels;
+        uint8_t* frame;
+        uint8_t frameSize;
+        uint8_t frameLength;        // Bytes of the open frame, 0 = none open
+        SampleEncoding encoding;
+        uint8_t sequence;
+        uint8_t sweepsPerFrame;
+        uint8_t keyframeInterval;   // In frames, 0 = only after reset()
+        uint8_t sinceKeyframe;
+        bool keyframeDue;
+        
+        uint16_t delta(uint8_t channel, uint16_t value, bool fromZero) const {
+            return SampleFrame::zigzag((int16_t)(uint16_t)(value - (fromZero ? 0 : previous[channel])));
+        }
+        
+    public:
+        SampleEncoder(uint16_t* state, uint8_t channels, uint8_t* buffer, uint8_t bufferSize,
+                      SampleEncoding mode = SampleEncoding::AUTO)
+            : previous(state), numChannels(channels), frame(buffer), frameSize(bufferSize), frameLength(0),
+              encoding(mode), sequence(0), sweepsPerFrame(1), keyframeInterval(32), sinceKeyframe(0),
+              keyframeDue(true) {}
+        
+        // Drop any open frame; the next one is a keyframe
+        void reset() {
+            frameLength = 0;
+            keyframeDue = true;
+        }
+        
+        void setEncoding(SampleEncoding mode) { encoding = mode; }
+        void setKeyframeInterval(uint8_t frames) { keyframeInterval = frames; }
+        
+        // Sweeps collected into one frame before it is closed. More sweeps
+        // per frame spread the header and CRC over more samples.
+        void setSweepsPerFrame(uint8_t sweeps) { sweepsPerFrame = sweeps ? sweeps : 1; }
+        
+        // Add one sweep, values[0..count) for channels firstChannel onwards.
+        // On OK, length is the frame length when this closed a frame (send
+        // getFrame() before the next call), or 0 when the sweep was buffered.
+        // Sweeps in one frame must cover the same channels; a different range
+        // returns ERROR_CHANNEL_INVALID, so flush() before changing it.
+        // ERROR_OVERFLOW means the sweep does not fit the buffer. A rejected
+        // sweep leaves the encoder unchanged.
+        MUXStatus encode(const uint16_t* values, uint8_t count, uint8_t& length, uint8_t firstChannel = 0) {
+            length = 0;
+            if (count == 0 || firstChannel + count > numChannels) return MUXStatus::ERROR_CHANNEL_INVALID;
+            if (frameLength && (frame[3] != firstChannel || frame[4] != count)) return MUXStatus::ERROR_CHANNEL_INVALID;
+            
+            bool key = frameLength ? (frame[1] & SampleFrame::KEYFRAME) != 0
+                                   : keyframeDue || (keyframeInterval && sinceKeyframe >= keyframeInterval);
+            bool fromZero = key && frameLength == 0;
+            
+            // Size both encodings before writing anything
+            uint16_t varintBytes = 0;
+            uint16_t widest = 0;
+            for (uint8_t i = 0; i < count; i++) {
+                uint16_t z = delta(firstChannel + i, values[i], fromZero);
+                varintBytes += SampleFrame::varintSize(z);
+                widest |= z;
+            }
+            uint8_t width = SampleFrame::bitWidth(widest);
+            uint16_t packedBytes = ((uint16_t)count * width + 7) / 8;
+            
+            bool packed = (encoding == SampleEncoding::PACKED) ||
+                          (encoding == SampleEncoding::AUTO && packedBytes < varintBytes);
+            uint16_t start = frameLength ? frameLength : SampleFrame::HEADER;
+            uint16_t end = start + 1 + (packed ? packedBytes : varintBytes);
+            if (end + 2 > frameSize) return MUXStatus::ERROR_OVERFLOW;
+            
+            if (!frameLength) {
+                frame[0] = SampleFrame::SYNC;
+                frame[1] = key ? SampleFrame::KEYFRAME : 0;
+                frame[2] = sequence;
+                frame[3] = firstChannel;
+                frame[4] = count;
+                frame[5] = 0;
+            }
+            
+            uint8_t* out = frame + start;
+            *out++ = packed ? width : SampleFrame::VARINT_SWEEP;
+            uint32_t bits = 0;
+            uint8_t pending = 0;
+            for (uint8_t i = 0; i < count; i++) {
+                uint8_t ch = firstChannel + i;
+                uint16_t z = delta(ch, values[i], fromZero);
+                previous[ch] = values[i];
+                
+                if (packed) {
+                    bits |= (uint32_t)z << pending;
+                    pending += width;
+                    while (pending >= 8) {
+                        *out++ = (uint8_t)bits;
+                        bits >>= 8;
+                        pending -= 8;
+                    }
+                } else {
+                    while (z >= 0x80) {
+                        *out++ = (uint8_t)z | 0x80;
+                        z >>= 7;
+                    }
+                    *out++ = (uint8_t)z;
+                }
+            }
+            if (pending) *out++ = (uint8_t)bits;
+            
+            frameLength = end;
+            frame[5]++;
+            
+            // Close when full, or when a worst-case sweep would no longer fit
+            uint16_t worst = 1 + (uint16_t)count * (encoding == SampleEncoding::VARINT ? 3 : 2);
+            if (frame[5] >= sweepsPerFrame || frameLength + worst + 2 > frameSize) {
+                length = flush();
+            }
+            return MUXStatus::OK;
+        }
+        
+        // Close the open frame. Returns its length, 0 if none was open.
+        uint8_t flush() {
+            if (!frameLength) return 0;
+            
+            frame[6] = frameLength - SampleFrame::HEADER;
+            uint16_t crc = Utility::calculateCRC(frame, frameLength);
+            frame[frameLength] = crc & 0xFF;
+            frame[frameLength + 1] = crc >> 8;
+            uint8_t length = frameLength + 2;
+            
+            if (frame[1] & SampleFrame::KEYFRAME) {
+                sinceKeyframe = 1;
+                keyframeDue = false;
+            } else if (sinceKeyframe < 255) {
+                sinceKeyframe++;
+            }
+            sequence++;
+            frameLength = 0;
+            return length;
+        }
+        
+        const uint8_t* getFrame() const { return frame; }
+        uint8_t getSequence() const { return sequence; }
+    };
+
+    // Called by SampleDecoder for every sweep it unpacks
+    typedef void (*SweepCallback)(uint8_t firstChannel, uint8_t count, const uint16_t* values);
+
+    // Rebuilds channel values from frames, either whole (decode()) or one
+    // received byte at a time (feed()). After a lost or corrupt frame,
+    // delta frames are ignored until the next keyframe.
+    class SampleDecoder {
+    private:
+        uint16_t* values;
+        uint8_t numChannels;
+        uint8_t* frame;
+        uint8_t frameSize;
+        uint8_t received;           // Bytes of the current frame collected by feed()
+        uint8_t expected;           // Next sequence number
+        bool started;
+        bool synced;
+        SweepCallback sweepCallback;
+        uint16_t lostFrames;
+        uint16_t frameErrors;
+        
+        static bool readVarint(const uint8_t*& in, const uint8_t* end, uint16_t& value) {
+            uint32_t result = 0;
+            for (uint8_t shift = 0; shift < 21; shift += 7) {
+                if (in >= end) return false;
+                uint8_t b = *in++;
+                result |= (uint32_t)(b & 0x7F) << shift;
+                if (!(b & 0x80)) {
+                    value = (uint16_t)result;
+                    return true;
+                }
+            }
+            return false;
+        }
+        
+        MUXStatus corrupt() {
+            synced = false;
+            frameErrors++;
+            return MUXStatus::ERROR_COMMUNICATION;
+        }
+        
+    public:
+        SampleDecoder(uint16_t* state, uint8_t channels, uint8_t* buffer, uint8_t bufferSize)
+            : values(state), numChannels(channels), frame(buffer), frameSize(bufferSize),
+              received(0), expected(0), started(false), synced(false), sweepCallback(nullptr),
+              lostFrames(0), frameErrors(0) {}
+              
+        void reset() {
+            received = 0;
+            started = false;
+            synced = false;
+        }
+        
+        void onSweep(SweepCallback callback) { sweepCallback = callback; }
+        
+        // Apply one complete frame. ERROR_NOT_ENABLED means a delta frame
+        // arrived while waiting for a keyframe.
+        MUXStatus decode(const uint8_t* data, uint8_t length) {
+            if (length < SampleFrame::OVERHEAD || data[0] != SampleFrame::SYNC ||
+                data[6] + SampleFrame::OVERHEAD != length) {
+                frameErrors++;
+                return MUXStatus::ERROR_COMMUNICATION;
+            }
+            uint16_t crc = data[length - 2] | (uint16_t)data[length - 1] << 8;
+            if (Utility::calculateCRC((uint8_t*)data, length - 2) != crc) {
+                frameErrors++;
+                return MUXStatus::ERROR_COMMUNICATION;
+            }
+            
+            uint8_t sequence = data[2];
+            if (started && sequence != expected) {
+                lostFrames += (uint8_t)(sequence - expected);
+                synced = false;
+            }
+            started = true;
+            expected = sequence + 1;
+            
+            bool key = (data[1] & SampleFrame::KEYFRAME) != 0;
+            uint8_t first = data[3];
+            uint8_t count = data[4];
+            if (!key && !synced) return MUXStatus::ERROR_NOT_ENABLED;
+            if (first + count > numChannels) return MUXStatus::ERROR_CHANNEL_INVALID;
+            
+            const uint8_t* in = data + SampleFrame::HEADER;
+            const uint8_t* end = in + data[6];
+            for (uint8_t sweep = 0; sweep < data[5]; sweep++) {
+                if (in >= end) return corrupt();
+                uint8_t tag = *in++;
+                bool packed = (tag != SampleFrame::VARINT_SWEEP);
+                if (packed && tag > 16) return corrupt();
+                
+                uint32_t bits = 0;
+                uint8_t available = 0;
+                for (uint8_t i = 0; i < count; i++) {
+                    uint16_t z;
+                    if (packed) {
+                        while (available < tag && in < end) {
+                            bits |= (uint32_t)*in++ << available;
+                            available += 8;
+                        }
+                        if (available < tag) return corrupt();
+                        z = (uint16_t)(bits & ((1UL << tag) - 1));
+                        bits >>= tag;
+                        available -= tag;
+                    } else if (!readVarint(in, end, z)) {
+                        return corrupt();
+                    }
+                    
+                    uint16_t base = (key && sweep == 0) ? 0 : values[first + i];
+                    values[first + i] = base + (uint16_t)SampleFrame::unzigzag(z);
+                }
+                if (sweepCallback) sweepCallback(first, count, values + first);
+            }
+            
+            synced = true;
+            return MUXStatus::OK;
+        }
+        
+        // Feed one received byte. Returns true when it completed a frame
+        // that was applied. Bytes outside frames are skipped.
+        bool feed(uint8_t byte) {
+            if (received == 0 && byte != SampleFrame::SYNC) return false;
+            frame[received++] = byte;
+            
+            while (received >= SampleFrame::HEADER) {
+                uint16_t total = frame[6] + SampleFrame::OVERHEAD;
+                bool fits = total <= frameSize;
+                if (fits && received < total) return false;
+                
+                MUXStatus status = MUXStatus::ERROR_COMMUNICATION;
+                if (fits) {
+                    status = decode(frame, total);
+                } else {
+                    frameErrors++;
+                }
+                
+                // Drop the frame, or only its sync byte if it was corrupt,
+                // and keep any bytes after it
+                uint8_t used = (status != MUXStatus::ERROR_COMMUNICATION) ? total : 1;
+                while (used < received && frame[used] != SampleFrame::SYNC) used++;
+                memmove(frame, frame + used, received - used);
+                received -= used;
+                if (status == MUXStatus::OK) return true;
+            }
+            return false;
+        }
+        
+        bool isSynced() const { return synced; }
+        uint8_t getSequence() const { return expected - 1; }     // Of the last valid frame
+        uint16_t getValue(uint8_t channel) const { return channel < numChannels ? values[channel] : 0; }
+        uint16_t getLostFrames() const { return lostFrames; }
+        uint16_t getFrameErrors() const { return frameErrors; }
+    };
+}
+
+#endif
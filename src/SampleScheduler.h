@@ -0,0 +1,276 @@
+// Multi-Rate Sampling Scheduler (SampleScheduler.h)
+#ifndef SAMPLESCHEDULER_H
+#define SAMPLESCHEDULER_H
+
+#include "MUXLib.h"
+#include "AnalogMUX.h"
+
+// Longest period as a power-of-two multiple of the base period
+#ifndef MUXLIB_SCHEDULER_MAX_SHIFT
+    #define MUXLIB_SCHEDULER_MAX_SHIFT 15
+#endif
+
+namespace MUXLib {
+    // Called with the mux switched to 'channel'; read the device there
+    typedef void (*SampleHandler)(uint8_t channel);
+
+    // Called with the value read from an analog mux channel
+    typedef void (*ValueHandler)(uint8_t channel, uint16_t value);
+
+    // Rate-monotonic sampler for channels with different rates. Time is
+    // split into frames of the base period; each channel's period is
+    // rounded down to a power-of-two number of frames, so all periods are
+    // harmonic and the plan repeats exactly. build() gives every channel
+    // a phase that spreads the load evenly across frames. Within a frame
+    // samples run by priority, then in channel order alternating up and
+    // down between frames, so consecutive frames tend to meet on the same
+    // channel and skip a switch (and, on analog muxes, the settling wait).
+    // A frame that finishes after its end is counted as a deadline miss.
+    class SampleScheduler {
+    private:
+        struct ChannelPlan {
+            uint16_t phase;     // Frame offset within the period
+            uint8_t shift;      // Period = basePeriod << shift
+            uint8_t priority;
+            bool active;
+        };
+        
+        MUXManager& mux;
+        AnalogMUX* analog;
+        ChannelPlan* plan;
+        uint8_t* order;         // Scratch list for one frame
+        uint8_t numChannels;
+        uint32_t basePeriod;    // microseconds
+        uint16_t sampleCost;    // Estimated microseconds per sample, 0 = unknown
+        bool built;
+        bool running;
+        bool routed;            // Mux already switched by the scheduler
+        
+        SampleHandler sampleHandler;
+        ValueHandler valueHandler;
+        
+        uint32_t frame;
+        uint32_t frameStart;
+        uint32_t deadlineMisses;
+        uint32_t framesSkipped;
+        uint32_t maxFrameMicros;
+        uint32_t switchCount;
+        
+        bool dueIn(uint8_t channel, uint32_t frameNumber) const {
+            const ChannelPlan& p = plan[channel];
+            return p.active && ((frameNumber - p.phase) & ((1UL << p.shift) - 1)) == 0;
+        }
+        
+        // Samples due in a frame, in execution order
+        uint8_t buildFrame(uint32_t frameNumber) {
+            bool descending = frameNumber & 0x01;
+            uint8_t count = 0;
+            
+            for (uint8_t i = 0; i < numChannels; i++) {
+                uint8_t ch = descending ? numChannels - 1 - i : i;
+                if (!dueIn(ch, frameNumber)) continue;
+                
+                // Insert by priority, keeping the serpentine order among equals
+                uint8_t pos = count;
+                while (pos > 0 && plan[order[pos - 1]].priority < plan[ch].priority) {
+                    order[pos] = order[pos - 1];
+                    pos--;
+                }
+                order[pos] = ch;
+                count++;
+            }
+            return count;
+        }
+        
+        void sample(uint8_t channel) {
+            if (analog) {
+                if (!analog->isSettled(channel)) switchCount++;
+                uint16_t value = analog->readChannel(channel);
+                if (valueHandler) valueHandler(channel, value);
+            } else {
+                if (!routed || mux.getChannel() != channel) {
+                    if (mux.setChannel(channel) != MUXStatus::OK) return;
+                    routed = true;
+                    switchCount++;
+                }
+            }
+            if (sampleHandler) sampleHandler(channel);
+        }
+        
+    public:
+        SampleScheduler(MUXManager& device, uint32_t basePeriodMicros)
+            : mux(device), analog(nullptr), numChannels(device.getMaxChannels()),
+              basePeriod(basePeriodMicros), sampleCost(0), built(false), running(false),
+              routed(false), sampleHandler(nullptr), valueHandler(nullptr), frame(0), frameStart(0) {
+            plan = (ChannelPlan*)malloc(numChannels * sizeof(ChannelPlan));
+            order = (uint8_t*)malloc(numChannels);
+            if (plan) memset(plan, 0, numChannels * sizeof(ChannelPlan));
+            resetStatistics();
+        }
+        
+        // Analog muxes are read by the scheduler and values passed to onValue()
+        SampleScheduler(AnalogMUX& device, uint32_t basePeriodMicros)
+            : SampleScheduler(static_cast<MUXManager&>(device), basePeriodMicros) {
+            analog = &device;
+        }
+        
+        ~SampleScheduler() {
+            if (plan) free(plan);
+            if (order) free(order);
+        }
+        
+        // Sample a channel at least every periodMicros. Higher priority
+        // channels go first within a frame.
+        MUXStatus addChannel(uint8_t channel, uint32_t periodMicros, uint8_t priority = 0) {
+            if (!plan || !order) return MUXStatus::ERROR_INIT;
+            if (channel >= numChannels) return MUXStatus::ERROR_CHANNEL_INVALID;
+            if (periodMicros < basePeriod) return MUXStatus::ERROR_OVERFLOW;
+            
+            uint8_t shift = 0;
+            while (shift < MUXLIB_SCHEDULER_MAX_SHIFT && (periodMicros >> (shift + 1)) >= basePeriod) {
+                shift++;
+            }
+            
+            plan[channel].shift = shift;
+            plan[channel].priority = priority;
+            plan[channel].phase = 0;
+            plan[channel].active = true;
+            built = false;
+            return MUXStatus::OK;
+        }
+        
+        void removeChannel(uint8_t channel) {
+            if (plan && channel < numChannels) {
+                plan[channel].active = false;
+                built = false;
+            }
+        }
+        
+        void onSample(SampleHandler handler) { sampleHandler = handler; }
+        void onValue(ValueHandler handler) { valueHandler = handler; }
+        
+        // Expected cost of one sample, lets build() reject plans that cannot fit
+        void setSampleCost(uint16_t microseconds) { sampleCost = microseconds; }
+        
+        // Assign phases, fastest channels first, each to the least loaded
+        // frames of its period. Returns ERROR_OVERFLOW if a frame would
+        // exceed the base period at the configured sample cost.
+        MUXStatus build() {
+            if (!plan || !order) return MUXStatus::ERROR_INIT;
+            
+            uint8_t maxShift = 0;
+            for (uint8_t ch = 0; ch < numChannels; ch++) {
+                if (plan[ch].active && plan[ch].shift > maxShift) maxShift = plan[ch].shift;
+            }
+            
+            // Load per frame, folded onto 8 slots so the planner needs no
+            // hyperperiod-sized buffer (conservative for slow channels)
+            const uint8_t SLOTS = 8;
+            uint16_t load[SLOTS];
+            memset(load, 0, sizeof(load));
+            uint8_t slotShift = maxShift < 3 ? maxShift : 3;
+            uint16_t slots = 1 << slotShift;
+            uint16_t peak = 0;
+            uint16_t spread = 0;
+            
+            for (uint8_t shift = 0; shift <= maxShift; shift++) {
+                for (uint8_t ch = 0; ch < numChannels; ch++) {
+                    ChannelPlan& p = plan[ch];
+                    if (!p.active || p.shift != shift) continue;
+                    
+                    // Choose the phase whose frames carry the least load
+                    uint16_t period = 1 << shift;
+                    uint16_t step = period < slots ? period : slots;
+                    uint16_t bestPhase = 0;
+                    uint16_t bestLoad = 0xFFFF;
+                    for (uint16_t phase = 0; phase < step; phase++) {
+                        uint16_t worst = 0;
+                        for (uint16_t s = phase; s < slots; s += step) {
+                            if (load[s] > worst) worst = load[s];
+                        }
+                        if (worst < bestLoad) {
+                            bestLoad = worst;
+                            bestPhase = phase;
+                        }
+                    }
+                    
+                    // Slow channels also rotate through the rest of their period
+                    p.phase = bestPhase;
+                    if (period > slots) {
+                        p.phase += slots * (spread++ % (period / slots));
+                    }
+                    for (uint16_t s = bestPhase; s < slots; s += step) {
+                        load[s]++;
+                        if (load[s] > peak) peak = load[s];
+                    }
+                }
+            }
+            
+            built = true;
+            if (sampleCost && (uint32_t)peak * sampleCost > basePeriod) return MUXStatus::ERROR_OVERFLOW;
+            return MUXStatus::OK;
+        }
+        
+        void start() {
+            if (!built) build();
+            frame = 0;
+            frameStart = micros();
+            routed = false;
+            running = true;
+        }
+        
+        void stop() { running = false; }
+        
+        // Call from loop(): runs the current frame once it is due
+        void update() {
+            if (!running) return;
+            
+            uint32_t now = micros();
+            if ((int32_t)(now - frameStart) < 0) return;
+            
+            // Far behind (e.g. loop() blocked): drop whole frames to resync
+            uint32_t late = now - frameStart;
+            if (late >= basePeriod) {
+                uint32_t missed = late / basePeriod;
+                frame += missed;
+                frameStart += missed * basePeriod;
+                framesSkipped += missed;
+                deadlineMisses += missed;
+            }
+            
+            uint8_t count = buildFrame(frame);
+            for (uint8_t i = 0; i < count; i++) {
+                sample(order[i]);
+            }
+            
+            uint32_t elapsed = micros() - frameStart;
+            if (elapsed > maxFrameMicros) maxFrameMicros = elapsed;
+            if (elapsed > basePeriod) deadlineMisses++;
+            
+            frame++;
+            frameStart += basePeriod;
+        }
+        
+        // Period actually used for a channel (0 if not scheduled)
+        uint32_t getEffectivePeriod(uint8_t channel) const {
+            if (!plan || channel >= numChannels || !plan[channel].active) return 0;
+            return basePeriod << plan[channel].shift;
+        }
+        
+        void resetStatistics() {
+            deadlineMisses = 0;
+            framesSkipped = 0;
+            maxFrameMicros = 0;
+            switchCount = 0;
+        }
+        
+        uint32_t getDeadlineMisses() const { return deadlineMisses; }
+        uint32_t getFramesSkipped() const { return framesSkipped; }
+        uint32_t getMaxFrameMicros() const { return maxFrameMicros; }
+        uint32_t getSwitchCount() const { return switchCount; }
+        uint32_t getFrameCount() const { return frame; }
+        bool isRunning() const { return running; }
+    };
+}
+
+#endif
@@ -8,6 +8,7 @@
 #if defined(ESP32)
     #define FAST_GPIO_AVAILABLE
     #include "driver/gpio.h"
+    #include "esp_timer.h"
 #elif defined(ESP8266)
     #define FAST_GPIO_AVAILABLE
     #include "gpio.h"
@@ -58,6 +59,54 @@ namespace MUXLib {
             }
         }
         
+        // Precompute the GPIO set/clear words that select a channel. Returns
+        // false (and zero masks) where the control pins cannot be written as
+        // one register word, writeMasks() then falls back to per-pin writes.
+        bool channelMasks(uint8_t channel, uint32_t& setMask, uint32_t& clearMask) const {
+            setMask = 0;
+            clearMask = 0;
+            #ifdef FAST_GPIO_AVAILABLE
+            for (uint8_t i = 0; i < numPins; i++) {
+                if (pins[i] >= 32) {
+                    setMask = 0;
+                    clearMask = 0;
+                    return false;
+                }
+                if ((channel >> i) & 0x01) {
+                    setMask |= (1UL << pins[i]);
+                } else {
+                    clearMask |= (1UL << pins[i]);
+                }
+            }
+            return true;
+            #else
+            return false;
+            #endif
+        }
+        
+        // Select a channel from masks made by channelMasks(); safe in an ISR
+        void MUXLIB_ISR_ATTR writeMasks(uint8_t channel, uint32_t setMask, uint32_t clearMask) {
+            #if defined(ESP32)
+            if (setMask | clearMask) {
+                GPIO.out_w1ts = setMask;
+                GPIO.out_w1tc = clearMask;
+                currentChannel = channel;
+                return;
+            }
+            #elif defined(ESP8266)
+            if (setMask | clearMask) {
+                GPOS = setMask;
+                GPOC = clearMask;
+                currentChannel = channel;
+                return;
+            }
+            #endif
+            for (uint8_t i = 0; i < numPins; i++) {
+                fastDigitalWrite(pins[i], (channel >> i) & 0x01);
+            }
+            currentChannel = channel;
+        }
+        
         MUXStatus begin() override {
             if (!pins) return MUXStatus::ERROR_INIT;
             
@@ -70,6 +119,53 @@ namespace MUXLib {
             enable();
             return MUXStatus::OK;
         }
+        
+        // Select every channel and read the control pins back
+        bool runSelfTest(SelfTestResult& result) override {
+            memset(&result, 0, sizeof(result));
+            if (!pins) return false;
+            
+            uint32_t start = micros();
+            uint8_t previous = currentChannel;
+            
+            for (uint8_t ch = 0; ch < maxChannels; ch++) {
+                bool ok = (setChannel(ch) == MUXStatus::OK);
+                for (uint8_t i = 0; ok && i < numPins; i++) {
+                    if ((digitalRead(pins[i]) != 0) != (bool)((ch >> i) & 0x01)) {
+                        ok = false;
+                    }
+                }
+                if (ok) {
+                    result.passMask |= (1UL << ch);
+                } else {
+                    result.failMask |= (1UL << ch);
+                }
+            }
+            
+            setChannel(previous);
+            result.durationMicros = micros() - start;
+            return result.failMask == 0;
+        }
+        
+        void sleep() override {
+            if (sleeping || !enabled || !pins) return;
+            
+            for (uint8_t i = 0; i < numPins; i++) {
+                fastDigitalWrite(pins[i], LOW);
+            }
+            enabled = false;
+            sleeping = true;
+        }
+        
+        void wake() override {
+            if (!sleeping) return;
+            
+            for (uint8_t i = 0; i < numPins; i++) {
+                fastDigitalWrite(pins[i], (currentChannel >> i) & 0x01);
+            }
+            sleeping = false;
+            enabled = true;
+        }
     };
 
     // Video Multiplexer for composite/component video
@@ -79,10 +175,29 @@ namespace MUXLib {
         bool syncEnabled;
         uint8_t videoType; // 0=composite, 1=component
         
+        // Interrupt sync: setChannel() parks the switch here and the sync
+        // edge ISR applies it with precomputed register writes
+        bool interruptSync;
+        volatile uint8_t pendingChannel;   // 255 = nothing pending
+        uint32_t pendingSet;
+        uint32_t pendingClear;
+        uint32_t pendingSince;
+        uint32_t syncTimeout;              // microseconds, 0 = wait forever
+        
+        bool MUXLIB_ISR_ATTR onInterruptISR() override {
+            if (interruptSync && pendingChannel != 255) {
+                writeMasks(pendingChannel, pendingSet, pendingClear);
+                pendingChannel = 255;
+            }
+            return interruptHandler == nullptr;
+        }
+        
     public:
         VideoMUX(uint8_t* controlPins, uint8_t pinCount, uint8_t sync = 255, uint8_t type = 0)
             : FastMUX(controlPins, pinCount, 1 << pinCount),
-              syncPin(sync), syncEnabled(false), videoType(type) {}
+              syncPin(sync), syncEnabled(false), videoType(type),
+              interruptSync(false), pendingChannel(255), pendingSet(0), pendingClear(0),
+              pendingSince(0), syncTimeout(0) {}
               
         MUXStatus begin() override {
             MUXStatus status = FastMUX::begin();
@@ -99,10 +214,29 @@ namespace MUXLib {
         MUXStatus setChannel(uint8_t channel) override {
             if (!isValidChannel(channel)) return MUXStatus::ERROR_CHANNEL_INVALID;
             if (!enabled) return MUXStatus::ERROR_NOT_ENABLED;
+            MUXLIB_DIAG_SCOPE(setChannelHistogram);
+            MUXLIB_TRACE_SCOPE(channel);
+            MUXLIB_DIAG(diagSwitch(channel));
+            
+            // Queue for the next sync edge and return; a newer request
+            // replaces one that has not been applied yet
+            if (syncEnabled && interruptSync) {
+                uint32_t setMask, clearMask;
+                channelMasks(channel, setMask, clearMask);
+                noInterrupts();
+                pendingSet = setMask;
+                pendingClear = clearMask;
+                pendingSince = micros();
+                pendingChannel = channel;
+                interrupts();
+                return MUXStatus::OK;
+            }
             
             // Wait for vertical sync if enabled
             if (syncEnabled) {
+                uint32_t start = micros();
                 while (digitalRead(syncPin) == HIGH) {
+                    if (syncTimeout && (micros() - start) >= syncTimeout) break;
                     delayMicros(1);
                 }
             }
@@ -119,52 +253,339 @@ namespace MUXLib {
         void setSyncEnabled(bool enable) {
             syncEnabled = enable && (syncPin != 255);
         }
+        
+        // Switch on the sync edge from an interrupt instead of busy-waiting.
+        // setChannel() then returns at once; getChannel() reports the new
+        // channel once it has been applied.
+        MUXStatus enableSyncInterrupt(InterruptMode edge = InterruptMode::FALLING_EDGE) {
+            if (syncPin == 255) return MUXStatus::ERROR_INIT;
+            
+            MUXStatus status = attachInterrupt(interruptHandler, syncPin, edge);
+            if (status != MUXStatus::OK) return status;
+            interruptSync = true;
+            return MUXStatus::OK;
+        }
+        
+        // A switch still waiting for its sync edge is applied now, since
+        // setChannel() has already reported it as done
+        void disableSyncInterrupt() {
+            interruptSync = false;
+            detachInterrupt();
+            pinMode(syncPin, INPUT);
+            if (pendingChannel != 255) {
+                writeMasks(pendingChannel, pendingSet, pendingClear);
+                pendingChannel = 255;
+            }
+        }
+        
+        // Longest wait for a sync edge before switching anyway (0 = no limit).
+        // In interrupt mode the timeout is enforced by update().
+        void setSyncTimeout(uint32_t microseconds) {
+            syncTimeout = microseconds;
+        }
+        
+        // Call from loop() in interrupt mode: applies a pending switch whose
+        // sync edge did not arrive within the timeout (e.g. no video signal)
+        void update() {
+            if (!interruptSync || !syncTimeout) return;
+            
+            noInterrupts();
+            if (pendingChannel != 255 && (micros() - pendingSince) >= syncTimeout) {
+                writeMasks(pendingChannel, pendingSet, pendingClear);
+                pendingChannel = 255;
+            }
+            interrupts();
+        }
+        
+        bool isSwitchPending() const { return pendingChannel != 255; }
+        
+        // Switch without waiting for sync, so every channel can be read
+        // back at once. A switch queued for the next sync edge stays queued.
+        bool runSelfTest(SelfTestResult& result) override {
+            bool wasInterruptSync = interruptSync;
+            bool wasSyncEnabled = syncEnabled;
+            interruptSync = false;
+            syncEnabled = false;
+            
+            bool passed = FastMUX::runSelfTest(result);
+            
+            syncEnabled = wasSyncEnabled;
+            interruptSync = wasInterruptSync;
+            return passed;
+        }
     };
 
-    // Audio Multiplexer with fade control
+    // Attenuation output for AudioMUX: 0 = muted, 255 = full level
+    typedef void (*LevelCallback)(uint8_t level);
+
+    // Audio Multiplexer with fade control. With a level output (a PWM pin
+    // driving a VCA, or a callback writing a digital pot) setChannel()
+    // starts a crossfade and returns: fade out, switch at the minimum,
+    // fade in. Requests arriving mid-fade retarget it instead of queuing
+    // another full fade. Steps run from esp_timer on ESP32, elsewhere
+    // update() must be called from loop().
     class AudioMUX : public FastMUX {
     private:
+        enum class FadeState : uint8_t { IDLE, FADING_OUT, FADING_IN };
+        
         uint8_t fadeSteps;
-        uint16_t fadeDelay;
+        uint16_t fadeDelay;         // microseconds per step
         bool useFading;
         
+        uint8_t levelPin;
+        LevelCallback levelCallback;
+        volatile FadeState fadeState;
+        volatile uint8_t pendingChannel;   // 255 = no switch requested
+        uint8_t level;
+        uint32_t lastStep;
+        
+        #if defined(ESP32)
+        esp_timer_handle_t fadeTimer;
+        portMUX_TYPE fadeLock;      // Guards pendingChannel and fadeState
+        
+        static void fadeTimerCallback(void* arg) {
+            static_cast<AudioMUX*>(arg)->stepFade();
+        }
+        #endif
+        
+        // The fade steps run in the esp_timer task on ESP32, concurrently
+        // with setChannel(); elsewhere both run from loop()
+        void lockFade() {
+            #if defined(ESP32)
+            portENTER_CRITICAL(&fadeLock);
+            #endif
+        }
+        
+        void unlockFade() {
+            #if defined(ESP32)
+            portEXIT_CRITICAL(&fadeLock);
+            #endif
+        }
+        
+        // Clear the request if it is still for 'channel'
+        void takePending(uint8_t channel) {
+            lockFade();
+            if (pendingChannel == channel) pendingChannel = 255;
+            unlockFade();
+        }
+        
+        bool hasLevelOutput() const {
+            return levelPin != 255 || levelCallback != nullptr;
+        }
+        
+        void writeLevel(uint8_t value) {
+            level = value;
+            if (levelPin != 255) analogWrite(levelPin, value);
+            if (levelCallback) levelCallback(value);
+        }
+        
+        void writeChannel(uint8_t channel) {
+            for (uint8_t i = 0; i < numPins; i++) {
+                fastDigitalWrite(pins[i], (channel >> i) & 0x01);
+            }
+            currentChannel = channel;
+        }
+        
+        void startFadeTimer() {
+            lastStep = micros();
+            #if defined(ESP32)
+            if (!fadeTimer) {
+                esp_timer_create_args_t args = {};
+                args.callback = &AudioMUX::fadeTimerCallback;
+                args.arg = this;
+                args.name = "muxfade";
+                if (esp_timer_create(&args, &fadeTimer) != ESP_OK) {
+                    fadeTimer = nullptr;
+                    return;
+                }
+            }
+            esp_timer_stop(fadeTimer);
+            esp_timer_start_periodic(fadeTimer, fadeDelay < 50 ? 50 : fadeDelay);
+            #endif
+        }
+        
+        void stopFadeTimer() {
+            #if defined(ESP32)
+            if (fadeTimer) esp_timer_stop(fadeTimer);
+            #endif
+        }
+        
+        // One step of the fade state machine
+        void stepFade() {
+            uint8_t delta = (255 + fadeSteps - 1) / fadeSteps;
+            
+            switch (fadeState) {
+                case FadeState::FADING_OUT: {
+                    uint8_t target = pendingChannel;
+                    if (target == 255 || target == currentChannel) {
+                        // Request withdrawn or back to the playing source
+                        takePending(currentChannel);
+                        fadeState = FadeState::FADING_IN;
+                        break;
+                    }
+                    if (level > delta) {
+                        writeLevel(level - delta);
+                        break;
+                    }
+                    writeLevel(0);
+                    writeChannel(target);
+                    takePending(target);
+                    fadeState = FadeState::FADING_IN;
+                    break;
+                }
+                
+                case FadeState::FADING_IN: {
+                    takePending(currentChannel);
+                    if (pendingChannel != 255) {
+                        // New source requested: fade out from here
+                        fadeState = FadeState::FADING_OUT;
+                        break;
+                    }
+                    if (level < 255 - delta) {
+                        writeLevel(level + delta);
+                        break;
+                    }
+                    writeLevel(255);
+                    
+                    // Finish only if no request arrived meanwhile. The timer
+                    // is stopped under the lock, so a setChannel() that sees
+                    // IDLE always restarts it afterwards.
+                    lockFade();
+                    if (pendingChannel == 255 || pendingChannel == currentChannel) {
+                        pendingChannel = 255;
+                        fadeState = FadeState::IDLE;
+                        stopFadeTimer();
+                    } else {
+                        fadeState = FadeState::FADING_OUT;
+                    }
+                    unlockFade();
+                    break;
+                }
+                    
+                case FadeState::IDLE:
+                default:
+                    break;
+            }
+        }
+        
     public:
         AudioMUX(uint8_t* controlPins, uint8_t pinCount)
             : FastMUX(controlPins, pinCount, 1 << pinCount),
-              fadeSteps(16), fadeDelay(1), useFading(true) {}
-              
+              fadeSteps(16), fadeDelay(500), useFading(true),
+              levelPin(255), levelCallback(nullptr), fadeState(FadeState::IDLE),
+              pendingChannel(255), level(255), lastStep(0) {
+            #if defined(ESP32)
+            fadeTimer = nullptr;
+            fadeLock = portMUX_INITIALIZER_UNLOCKED;
+            #endif
+        }
+        
+        ~AudioMUX() {
+            #if defined(ESP32)
+            if (fadeTimer) {
+                esp_timer_stop(fadeTimer);
+                esp_timer_delete(fadeTimer);
+            }
+            #endif
+        }
+        
         MUXStatus setChannel(uint8_t channel) override {
             if (!isValidChannel(channel)) return MUXStatus::ERROR_CHANNEL_INVALID;
             if (!enabled) return MUXStatus::ERROR_NOT_ENABLED;
+            MUXLIB_DIAG_SCOPE(setChannelHistogram);
+            MUXLIB_TRACE_SCOPE(channel);
+            MUXLIB_DIAG(diagSwitch(channel));
             
-            if (useFading) {
-                // Fade out
-                for (uint8_t i = 0; i < fadeSteps; i++) {
-                    delayMicros(fadeDelay);
-                }
+            if (!useFading || !hasLevelOutput()) {
+                writeChannel(channel);
+                return MUXStatus::OK;
             }
             
-            // Switch channel
-            for (uint8_t i = 0; i < numPins; i++) {
-                fastDigitalWrite(pins[i], (channel >> i) & 0x01);
-            }
-            
-            if (useFading) {
-                // Fade in
-                for (uint8_t i = 0; i < fadeSteps; i++) {
-                    delayMicros(fadeDelay);
+            // A running fade picks the request up; only an idle one is
+            // started here. Both decisions are made under the fade lock.
+            bool start = false;
+            lockFade();
+            pendingChannel = channel;
+            if (fadeState == FadeState::IDLE) {
+                if (channel == currentChannel) {
+                    pendingChannel = 255;
+                } else {
+                    fadeState = FadeState::FADING_OUT;
+                    start = true;
                 }
             }
+            unlockFade();
             
-            currentChannel = channel;
+            if (start) startFadeTimer();
             return MUXStatus::OK;
         }
         
+        // Fade with 'steps' level changes each way, 'delayUs' apart
         void configureFade(uint8_t steps, uint16_t delayUs, bool enable = true) {
-            fadeSteps = steps;
+            fadeSteps = steps ? steps : 1;
             fadeDelay = delayUs;
             useFading = enable;
         }
+        
+        // PWM output (analogWrite) feeding the attenuator
+        void setLevelPin(uint8_t pin) {
+            levelPin = pin;
+            if (pin != 255) {
+                pinMode(pin, OUTPUT);
+                writeLevel(level);
+            }
+        }
+        
+        // Attenuator written by the application, e.g. a digital potentiometer
+        void setLevelCallback(LevelCallback callback) {
+            levelCallback = callback;
+            if (callback) writeLevel(level);
+        }
+        
+        // Advance the fade; call from loop() on targets without esp_timer
+        void update() {
+            #if !defined(ESP32)
+            if (fadeState == FadeState::IDLE) return;
+            
+            uint32_t now = micros();
+            while (fadeState != FadeState::IDLE && (now - lastStep) >= fadeDelay) {
+                lastStep += fadeDelay;
+                stepFade();
+            }
+            #endif
+        }
+        
+        bool isFading() const { return fadeState != FadeState::IDLE; }
+        uint8_t getLevel() const { return level; }
+        
+        // Switch directly with the output held at the minimum, so every
+        // channel can be read back at once. A fade in progress is paused
+        // and resumed from the same point afterwards.
+        bool runSelfTest(SelfTestResult& result) override {
+            lockFade();
+            stopFadeTimer();
+            FadeState savedState = fadeState;
+            uint8_t savedPending = pendingChannel;
+            fadeState = FadeState::IDLE;
+            pendingChannel = 255;
+            unlockFade();
+            
+            uint8_t savedLevel = level;
+            bool wasFading = useFading;
+            if (hasLevelOutput()) writeLevel(0);
+            useFading = false;
+            
+            bool passed = FastMUX::runSelfTest(result);
+            
+            useFading = wasFading;
+            if (hasLevelOutput()) writeLevel(savedLevel);
+            lockFade();
+            fadeState = savedState;
+            pendingChannel = savedPending;
+            unlockFade();
+            if (savedState != FadeState::IDLE) startFadeTimer();
+            return passed;
+        }
     };
 
     // High-speed data multiplexer with buffer
@@ -192,9 +613,14 @@ namespace MUXLib {
                     buffer[bufferIndex++] = channel;
                     return MUXStatus::OK;
                 }
+                MUXLIB_DIAG(diagOverflow());
                 return MUXStatus::ERROR_OVERFLOW;
             }
             
+            MUXLIB_DIAG_SCOPE(setChannelHistogram);
+            MUXLIB_TRACE_SCOPE(channel);
+            MUXLIB_DIAG(diagSwitch(channel));
+            
             // Direct channel switch
             for (uint8_t i = 0; i < numPins; i++) {
                 fastDigitalWrite(pins[i], (channel >> i) & 0x01);
@@ -0,0 +1,271 @@
+// Crosspoint / Matrix Switch Module (SwitchMatrix.h)
+#ifndef SWITCHMATRIX_H
+#define SWITCHMATRIX_H
+
+#include "MUXLib.h"
+#include "AnalogMUX.h"
+
+namespace MUXLib {
+    // N inputs x M outputs routing model. Connections are edited on a
+    // target bit-matrix and applied in one go: apply() diffs the target
+    // against the applied state, opens every connection that has to go
+    // before closing any new one (break-before-make across the whole
+    // matrix), and touches only the crosspoints that actually change.
+    class SwitchMatrix {
+    protected:
+        uint8_t numInputs;
+        uint8_t numOutputs;
+        uint8_t* applied;       // Bit (output * numInputs + input)
+        uint8_t* target;
+        uint16_t matrixBytes;
+        
+        // Close or open one crosspoint on the hardware
+        virtual MUXStatus writeCrosspoint(uint8_t input, uint8_t output, bool closed) = 0;
+        
+        // Latch pending crosspoint writes, for parts with a global update strobe
+        virtual MUXStatus commit() { return MUXStatus::OK; }
+        
+        // True if an output can only carry one input (1-of-N mux per output)
+        virtual bool exclusiveOutputs() const { return false; }
+        
+        uint16_t bitIndex(uint8_t input, uint8_t output) const {
+            return (uint16_t)output * numInputs + input;
+        }
+        
+        static bool getBit(const uint8_t* bits, uint16_t index) {
+            return bits[index >> 3] & (1 << (index & 0x07));
+        }
+        
+        static void setBit(uint8_t* bits, uint16_t index, bool value) {
+            if (value) {
+                bits[index >> 3] |= (1 << (index & 0x07));
+            } else {
+                bits[index >> 3] &= ~(1 << (index & 0x07));
+            }
+        }
+        
+        // Apply one phase of the diff: closing = false opens connections
+        // present only in 'applied', closing = true closes those only in 'target'
+        MUXStatus applyPhase(bool closing) {
+            for (uint16_t b = 0; b < matrixBytes; b++) {
+                uint8_t changed = applied[b] ^ target[b];
+                changed &= closing ? target[b] : applied[b];
+                
+                for (uint8_t bit = 0; changed; bit++, changed >>= 1) {
+                    if (!(changed & 0x01)) continue;
+                    
+                    uint16_t index = (b << 3) + bit;
+                    MUXStatus status = writeCrosspoint(index % numInputs, index / numInputs, closing);
+                    if (status != MUXStatus::OK) return status;
+                    setBit(applied, index, closing);
+                }
+            }
+            return commit();
+        }
+        
+    public:
+        SwitchMatrix(uint8_t inputs, uint8_t outputs)
+            : numInputs(inputs), numOutputs(outputs),
+              matrixBytes(((uint16_t)inputs * outputs + 7) / 8) {
+            applied = (uint8_t*)malloc(matrixBytes);
+            target = (uint8_t*)malloc(matrixBytes);
+            if (applied) memset(applied, 0, matrixBytes);
+            if (target) memset(target, 0, matrixBytes);
+        }
+        
+        virtual ~SwitchMatrix() {
+            if (applied) free(applied);
+            if (target) free(target);
+        }
+        
+        virtual MUXStatus begin() {
+            if (!applied || !target) return MUXStatus::ERROR_INIT;
+            return MUXStatus::OK;
+        }
+        
+        // Edit the target routing; nothing changes on the hardware until apply()
+        MUXStatus connect(uint8_t input, uint8_t output) {
+            if (input >= numInputs || output >= numOutputs) return MUXStatus::ERROR_CHANNEL_INVALID;
+            if (exclusiveOutputs()) {
+                disconnectOutput(output);
+            }
+            setBit(target, bitIndex(input, output), true);
+            return MUXStatus::OK;
+        }
+        
+        MUXStatus disconnect(uint8_t input, uint8_t output) {
+            if (input >= numInputs || output >= numOutputs) return MUXStatus::ERROR_CHANNEL_INVALID;
+            setBit(target, bitIndex(input, output), false);
+            return MUXStatus::OK;
+        }
+        
+        void disconnectOutput(uint8_t output) {
+            if (output >= numOutputs) return;
+            for (uint8_t in = 0; in < numInputs; in++) {
+                setBit(target, bitIndex(in, output), false);
+            }
+        }
+        
+        void clear() {
+            memset(target, 0, matrixBytes);
+        }
+        
+        // Replace the whole target with a packed bit-matrix of matrixBytes.
+        // Where outputs are exclusive, a target with two inputs on one
+        // output is refused and the current target is kept.
+        MUXStatus setTarget(const uint8_t* bits) {
+            if (exclusiveOutputs()) {
+                for (uint8_t out = 0; out < numOutputs; out++) {
+                    uint8_t inputs = 0;
+                    for (uint8_t in = 0; in < numInputs; in++) {
+                        if (getBit(bits, bitIndex(in, out)) && ++inputs > 1) {
+                            return MUXStatus::ERROR_CHANNEL_INVALID;
+                        }
+                    }
+                }
+            }
+            memcpy(target, bits, matrixBytes);
+            return MUXStatus::OK;
+        }
+        
+        // Drop unapplied edits
+        void revert() {
+            memcpy(target, applied, matrixBytes);
+        }
+        
+        // Number of crosspoint writes the next apply() will issue
+        uint16_t pendingOperations() const {
+            uint16_t count = 0;
+            for (uint16_t b = 0; b < matrixBytes; b++) {
+                for (uint8_t changed = applied[b] ^ target[b]; changed; changed &= changed - 1) {
+                    count++;
+                }
+            }
+            return count;
+        }
+        
+        // Break-before-make: all opens (then commit), then all closes (then commit)
+        MUXStatus apply() {
+            MUXStatus status = applyPhase(false);
+            if (status != MUXStatus::OK) return status;
+            return applyPhase(true);
+        }
+        
+        // Applied (hardware) state
+        bool isConnected(uint8_t input, uint8_t output) const {
+            if (input >= numInputs || output >= numOutputs) return false;
+            return getBit(applied, bitIndex(input, output));
+        }
+        
+        uint8_t getInputCount() const { return numInputs; }
+        uint8_t getOutputCount() const { return numOutputs; }
+        uint16_t getMatrixBytes() const { return matrixBytes; }
+        const uint8_t* getAppliedState() const { return applied; }
+    };
+
+    // Matrix built from one analog mux per output (e.g. an HC4051 per sink,
+    // all fed from the same sources). Each output carries at most one input;
+    // the mux enable pins provide the disconnects, so every mux needs one.
+    class MUXArrayMatrix : public SwitchMatrix {
+    private:
+        AnalogMUX** muxes;
+        
+    protected:
+        MUXStatus writeCrosspoint(uint8_t input, uint8_t output, bool closed) override {
+            AnalogMUX* mux = muxes[output];
+            if (!closed) {
+                mux->disable();
+                return MUXStatus::OK;
+            }
+            mux->enable();
+            return mux->setChannel(input);
+        }
+        
+        bool exclusiveOutputs() const override { return true; }
+        
+    public:
+        // muxList must stay valid and hold one mux per output
+        MUXArrayMatrix(AnalogMUX** muxList, uint8_t inputs, uint8_t outputs)
+            : SwitchMatrix(inputs, outputs), muxes(muxList) {}
+            
+        MUXStatus begin() override {
+            MUXStatus status = SwitchMatrix::begin();
+            if (status != MUXStatus::OK) return status;
+            
+            for (uint8_t out = 0; out < numOutputs; out++) {
+                // disable() alone leaves a mux without EN connected
+                if (muxes[out]->getEnablePin() == 255) return MUXStatus::ERROR_INIT;
+                status = muxes[out]->begin();
+                if (status != MUXStatus::OK) return status;
+                muxes[out]->disable();
+            }
+            return MUXStatus::OK;
+        }
+    };
+
+    // MT8816 8x16 analog crosspoint switch (AX0-AX3, AY0-AY2, DATA, STROBE)
+    class MT8816 : public SwitchMatrix {
+    private:
+        uint8_t axPins[4];
+        uint8_t ayPins[3];
+        uint8_t dataPin;
+        uint8_t strobePin;
+        uint8_t resetPin;
+        
+    protected:
+        MUXStatus writeCrosspoint(uint8_t input, uint8_t output, bool closed) override {
+            uint8_t ax = xAddress(input);
+            for (uint8_t i = 0; i < 4; i++) {
+                digitalWrite(axPins[i], (ax >> i) & 0x01);
+            }
+            for (uint8_t i = 0; i < 3; i++) {
+                digitalWrite(ayPins[i], (output >> i) & 0x01);
+            }
+            digitalWrite(dataPin, closed ? HIGH : LOW);
+            
+            // Data is latched into the addressed crosspoint while STROBE is high
+            digitalWrite(strobePin, HIGH);
+            delayMicroseconds(1);
+            digitalWrite(strobePin, LOW);
+            return MUXStatus::OK;
+        }
+        
+    public:
+        // AX code of an X line. The MT8816 decodes codes 6/7 as X12/X13 and
+        // codes 8-13 as X6-X11; the other lines use their own number.
+        static uint8_t xAddress(uint8_t x) {
+            if (x >= 6 && x < 12) return x + 2;
+            if (x >= 12 && x < 14) return x - 6;
+            return x;
+        }
+        
+        // Inputs are the 16 X lines, outputs the 8 Y lines
+        MT8816(uint8_t* axAddrPins, uint8_t* ayAddrPins, uint8_t data, uint8_t strobe,
+               uint8_t rstPin = 255)
+            : SwitchMatrix(16, 8), dataPin(data), strobePin(strobe), resetPin(rstPin) {
+            memcpy(axPins, axAddrPins, 4);
+            memcpy(ayPins, ayAddrPins, 3);
+        }
+        
+        MUXStatus begin() override {
+            MUXStatus status = SwitchMatrix::begin();
+            if (status != MUXStatus::OK) return status;
+            
+            for (uint8_t i = 0; i < 4; i++) pinMode(axPins[i], OUTPUT);
+            for (uint8_t i = 0; i < 3; i++) pinMode(ayPins[i], OUTPUT);
+            pinMode(dataPin, OUTPUT);
+            pinMode(strobePin, OUTPUT);
+            digitalWrite(strobePin, LOW);
+            
+            if (resetPin != 255) {
+                pinMode(resetPin, OUTPUT);
+                digitalWrite(resetPin, HIGH);  // Opens every crosspoint
+                delayMicroseconds(1);
+                digitalWrite(resetPin, LOW);
+            }
+            return MUXStatus::OK;
+        }
+    };
+}
+
+#endif